@@ -0,0 +1,78 @@
+/**
+ * @file args.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the command line parsing
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef E3B58A21_7C4D_4E96_A0F3_6D2B9C8E5A17
+#define E3B58A21_7C4D_4E96_A0F3_6D2B9C8E5A17
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>  // to check correctness of input
+#include <limits.h> // for INT_MIN and INT_MAX
+#include <stdint.h> // for SIZE_MAX
+
+int check_int_input(const char* par);
+
+/**
+ * @brief Check if the string parameter is a valid element count
+ * and convert it to size_t. If is invalid exit with failure
+ * 
+ * @param par string to be checked and converted
+ * @param elem_size size in bytes of an element (the count must be addressable)
+ * @return size_t The count converted from the string
+ */
+size_t check_size_input(const char* par, size_t elem_size);
+
+/**
+ * @brief Number of positional arguments, i.e. the arguments
+ * before the first optional "--name=value" one.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @return int the number of positional arguments (program name included)
+ */
+int count_positional(int argc, char* argv[]);
+
+/**
+ * @brief Look up an optional "--name=value" argument.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @param name name of the option, without the leading "--"
+ * @return const char* the value of the option, NULL if not given
+ */
+const char* get_opt(int argc, char* argv[], const char* name);
+
+#endif /* E3B58A21_7C4D_4E96_A0F3_6D2B9C8E5A17 */
@@ -0,0 +1,77 @@
+/**
+ * @file benchMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the in-process benchmark driver
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef A2C6E8F0_4B17_4D39_9E5A_7F1B3D8C0E42
+#define A2C6E8F0_4B17_4D39_9E5A_7F1B3D8C0E42
+
+#include "mergeMPI.h"
+
+// default unmeasured runs before the repetitions of each configuration
+#define BENCH_WARMUP 2
+// default measured repetitions of each configuration
+#define BENCH_REPS 10
+// values of an option list (--sort=0,1,2 ...)
+#define BENCH_MAX_LIST 16
+
+// phases timed by each repetition
+#define BENCH_READ   0
+#define BENCH_SORT   1
+#define BENCH_MERGE  2
+#define BENCH_TOTAL  3
+#define BENCH_PHASES 4
+
+/**
+ * @brief Benchmark driver for the key type DATATYPE, called by main with the
+ * key type selected by --dtype. MPI is initialized once and the input is
+ * loaded once; then every configuration (local sort, merge type, I/O version,
+ * chunk) runs warm-up runs and timed repetitions. For each configuration and
+ * phase the median, p5, p95, mean with its 95% confidence interval and the
+ * throughput are printed as ';' separated rows. The single repetitions can be
+ * written with --measures in
+ * dir/bench/Case_<sort + 1>/version_<v>/merge_<m>[_chunk_<c>]/size_<log2 n>/bench_<p>_<log2 n>.csv
+ * (the chunk only for the pipelined merge), apart from the measures of
+ * generate_measures.py: the times are taken in process around each phase
+ * (merge_phase_time is the merge call alone) and total_time has no mpirun
+ * start-up, unlike the elapsed column of those. extract_measures.py tables
+ * them separately when dir is the measures folder.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @return int exit status
+ */
+int bench_main(int argc, char* argv[]);
+
+#endif /* A2C6E8F0_4B17_4D39_9E5A_7F1B3D8C0E42 */
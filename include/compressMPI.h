@@ -0,0 +1,128 @@
+/**
+ * @file compressMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the compressed transfer of sorted runs
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef B5D91F3A_6E28_4C47_8A0B_2F7E4C19D6A3
+#define B5D91F3A_6E28_4C47_8A0B_2F7E4C19D6A3
+
+#include "mergeMPI.h"
+
+// bytes of the varint of a difference between two keys (7 bits per byte)
+#define VARINT_MAX ((8 * sizeof(DATATYPE) + 6) / 7)
+// bytes of the encoding of n keys in the worst case (see Encode_run)
+#define ENCODED_MAX(n) (sizeof(DATATYPE) + ((n) > 0 ? (n) - 1 : 0) * VARINT_MAX)
+
+/**
+ * @brief Bytes moved by the compressed sends of a process.
+ */
+typedef struct {
+  size_t raw_bytes;   // bytes of the keys sent
+  size_t sent_bytes;  // bytes of their encoding
+} Compress_stats;
+
+/**
+ * @brief Encode the sorted run X: the first key as it is, then the
+ * differences between consecutive keys as varints (LEB128). The keys are
+ * mapped to unsigned integers with the same order (see radix_sort), so the
+ * differences of a sorted run are small and non negative.
+ * 
+ * @param X the sorted run
+ * @param n the size of the run
+ * @param out destination, at least ENCODED_MAX(n) bytes
+ * @return size_t the bytes written
+ */
+size_t Encode_run(const DATATYPE* X, size_t n, unsigned char* out);
+
+/**
+ * @brief Decode n keys encoded by Encode_run.
+ * 
+ * @param in the encoding
+ * @param n the number of keys
+ * @param X destination of the n keys
+ * @return size_t the bytes read
+ */
+size_t Decode_run(const unsigned char* in, size_t n, DATATYPE* X);
+
+/**
+ * @brief Send the sorted list A to partner in encoded chunks of chunk keys:
+ * a ring of PIPELINE_DEPTH nonblocking sends overlaps the encoding of a chunk
+ * with the transfer of the previous ones.
+ * 
+ * @param A the sorted list
+ * @param n the size of A
+ * @param chunk keys of each message
+ * @param partner the receiving process
+ * @param comm the communicator
+ * @param stats the bytes sent are added here
+ */
+void Send_compressed(const DATATYPE* A, size_t n, size_t chunk, int partner, MPI_Comm comm, Compress_stats* stats);
+
+/**
+ * @brief Merge the sorted list A with a sorted list of nb keys received from
+ * partner in encoded chunks (see Send_compressed). Every chunk is decoded as
+ * soon as it arrives and merged with the keys of A that precede its last key,
+ * while the following chunks are in transit. Return result in C.
+ * 
+ * @param A the local sorted list
+ * @param na the size of A
+ * @param C output array for the merged list (na + nb elements)
+ * @param nb the size of the list to be received
+ * @param chunk keys of each message
+ * @param partner the process sending the list
+ * @param comm the communicator
+ */
+void Merge_compressed_stream(DATATYPE* A, size_t na, DATATYPE* C, size_t nb, size_t chunk, int partner, MPI_Comm comm);
+
+/**
+ * @brief Tree merge of Merge_sort with compressed messages: the sorted runs
+ * travel delta + varint encoded in chunks (see Send_compressed,
+ * Merge_compressed_stream), which shrinks the messages of runs with small
+ * gaps between the keys (large or skewed inputs).
+ * 
+ * PRE: *local_array holds the slice of the process (see Slice_offset)
+ * in a buffer of Merge_buffer_size(size, rank, n_rank) elements
+ * 
+ * @param local_array pointer to the sorted array from the process; at the end
+ * it points to the global sorted array (the buffer may have been swapped)
+ * @param size the number of elements of the global list
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param chunk keys of each message
+ * @param comm the communicator
+ * @param stats the bytes sent by the process
+ */
+void Merge_sort_compressed(DATATYPE** local_array, size_t size, int rank, int n_rank, size_t chunk, MPI_Comm comm, Compress_stats* stats);
+
+#endif /* B5D91F3A_6E28_4C47_8A0B_2F7E4C19D6A3 */
@@ -3,13 +3,70 @@
  * @author Mario Pellegrino
  * @author Francesco Sonnessa
  * @version 0.1
- * 
+ *
  * @copyright Copyright (c) 2021
- * 
+ *
  */
 #ifndef D43DE206_47A0_4420_BF3A_85D751B39CEF
 #define D43DE206_47A0_4420_BF3A_85D751B39CEF
 
-typedef int DATATYPE; // char, ints, unsigned, floats, doubles supported
+#include <stdint.h>
+#include <inttypes.h> // printf formats of the fixed width integers
+
+/*
+ * Key types. The typed sources are compiled once for each of them with
+ * DATATYPE_ID set (see CMakeLists.txt), and the key type is selected at
+ * runtime with --dtype (see main.c).
+ */
+#define DT_INT32  0
+#define DT_INT64  1
+#define DT_UINT64 2
+#define DT_FLOAT  3
+#define DT_DOUBLE 4
+
+#ifndef DATATYPE_ID
+#define DATATYPE_ID DT_INT32
+#endif
+
+#if DATATYPE_ID == DT_INT32
+typedef int32_t DATATYPE;
+#define MPITYPE MPI_INT32_T
+#define DATATYPE_FMT "%" PRId32
+#define DATATYPE_SUFFIX i32
+#define DATATYPE_NAME "int32"
+#elif DATATYPE_ID == DT_INT64
+typedef int64_t DATATYPE;
+#define MPITYPE MPI_INT64_T
+#define DATATYPE_FMT "%" PRId64
+#define DATATYPE_SUFFIX i64
+#define DATATYPE_NAME "int64"
+#elif DATATYPE_ID == DT_UINT64
+typedef uint64_t DATATYPE;
+#define MPITYPE MPI_UINT64_T
+#define DATATYPE_FMT "%" PRIu64
+#define DATATYPE_SUFFIX u64
+#define DATATYPE_NAME "uint64"
+#elif DATATYPE_ID == DT_FLOAT
+typedef float DATATYPE;
+#define MPITYPE MPI_FLOAT
+#define DATATYPE_FMT "%.9g"
+#define DATATYPE_SUFFIX f32
+#define DATATYPE_NAME "float"
+#elif DATATYPE_ID == DT_DOUBLE
+typedef double DATATYPE;
+#define MPITYPE MPI_DOUBLE
+#define DATATYPE_FMT "%.17g"
+#define DATATYPE_SUFFIX f64
+#define DATATYPE_NAME "double"
+#else
+#error "unknown DATATYPE_ID"
+#endif
+
+// name##_##DATATYPE_SUFFIX: the symbol of name compiled for this key type
+#define TYPED_CAT(name, suffix) name##_##suffix
+#define TYPED_NAME(name, suffix) TYPED_CAT(name, suffix)
+#define TYPED(name) TYPED_NAME(name, DATATYPE_SUFFIX)
+
+#include "typed_names.h"
 
 #endif /* D43DE206_47A0_4420_BF3A_85D751B39CEF */
@@ -0,0 +1,78 @@
+/**
+ * @file externalMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the out-of-core (external memory) parallel sort
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef E5B1D7A3_8C42_4E19_A6F0_2D9B3C7E5A18
+#define E5B1D7A3_8C42_4E19_A6F0_2D9B3C7E5A18
+
+#include "mergeMPI.h"
+
+// samples read from the file slice of each process to choose the splitters
+#define EXT_SAMPLES_PER_RANK 64
+// smallest buffer (in elements) given to a run during the k-way merge;
+// it bounds the number of runs merged in a single pass
+#define EXT_MIN_RUN_BUFFER 4096
+
+/**
+ * @brief Out-of-core parallel sort: the input file is sorted into the
+ * output file using at most (about) budget bytes of memory per process:
+ * the read and send buffers of the run formation take a quarter of it,
+ * the run buffer and the scratch of its sort the rest.
+ * 
+ * Run formation: splitters are chosen from samples of the file, then each process
+ * streams its file slice in chunks, sends every element to the process owning
+ * its key range (MPI_Alltoallv) and collects what it receives in a run buffer;
+ * full runs are sorted with the local sort algorithm and spilled to scratch files.
+ * A process never receives more than the free room of its run buffer at once:
+ * with skewed keys the exchange of a round is split in more of them.
+ * 
+ * Merge: each process merges its runs with a buffered k-way merge (in more passes
+ * if they are too many) and writes the result at its position in the output file.
+ * 
+ * @param filename name of the input file
+ * @param size number of elements in the input file
+ * @param out_filename name of the output file
+ * @param budget memory budget of each process, in bytes
+ * @param scratch_dir directory for the scratch files of the runs
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @param run_time output: mean time spent in run formation
+ * @param merge_time output: mean time spent merging the runs and writing the output
+ */
+void External_sort(char* filename, size_t size, const char* out_filename, size_t budget, const char* scratch_dir,
+                   int rank, int n_rank, MPI_Comm comm, double* run_time, double* merge_time);
+
+#endif /* E5B1D7A3_8C42_4E19_A6F0_2D9B3C7E5A18 */
@@ -0,0 +1,76 @@
+/**
+ * @file generateMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the parallel input generator
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef C34EA929_CF45_424E_8F81_09724226852C
+#define C34EA929_CF45_424E_8F81_09724226852C
+
+#include "mergeMPI.h"
+
+// elements generated and written by each collective write
+#define GEN_BLOCK (1 << 20)
+// default distinct keys of the few-unique distribution
+#define GEN_FEW_UNIQUE 16
+// default distinct keys of the Zipf distribution
+#define GEN_ZIPF_KEYS (1 << 20)
+// default exponent of the Zipf distribution
+#define GEN_ZIPF_S 1.1
+// default fraction of keys out of place in the nearly sorted distribution
+#define GEN_DISORDER 0.01
+
+// key distributions (--dist)
+#define GEN_UNIFORM    0
+#define GEN_SORTED     1
+#define GEN_REVERSE    2
+#define GEN_NEARLY     3
+#define GEN_ORGAN_PIPE 4
+#define GEN_ZIPF       5
+#define GEN_FEW        6
+#define GEN_EQUAL      7
+
+/**
+ * @brief Input generator for the key type DATATYPE, called by main with the
+ * key type selected by --dtype. Every process generates its slice of the file
+ * and writes it by blocks of GEN_BLOCK elements with collective MPI-IO writes.
+ * Element i depends only on the seed and on i, so the same seed gives the same
+ * file for any number of processes.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @return int exit status
+ */
+int gen_main(int argc, char* argv[]);
+
+#endif /* C34EA929_CF45_424E_8F81_09724226852C */
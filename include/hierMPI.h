@@ -0,0 +1,93 @@
+/**
+ * @file hierMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the node-aware hierarchical merge
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef B5E1C7A3_8D24_4A6F_93B0_2F7C6E1D4A58
+#define B5E1C7A3_8D24_4A6F_93B0_2F7C6E1D4A58
+
+#include "mergeMPI.h"
+
+/**
+ * @brief State of the hierarchical merge: the ranks of a node sort and
+ * merge their slices in a shared memory window of the node leader
+ * (node rank 0), then only the leaders take part in the tree merge.
+ */
+typedef struct {
+  MPI_Comm node_comm;   // the ranks of the node (or of the simulated node)
+  MPI_Comm leader_comm; // the node leaders, MPI_COMM_NULL on the other ranks
+  MPI_Win win;          // shared window allocated by the leader
+  DATATYPE* buf[2];     // the two halves (ping-pong) of the window, cap elements each
+  size_t cap;           // elements the leader holds at the end of the tree merge
+  size_t* node_offsets; // node_n + 1 offsets of the slices of the node ranks in the window
+  int node_rank, node_n;
+} Hier_merge;
+
+/**
+ * @brief Split comm in nodes (MPI_Comm_split_type with MPI_COMM_TYPE_SHARED)
+ * and allocate the shared window of each node. With node_size > 0 each node
+ * is further split in simulated nodes of node_size ranks, so that the
+ * hierarchy can be tested on a single machine.
+ * 
+ * @param h the state to initialize (see Hier_free)
+ * @param size the number of elements of the global list
+ * @param node_size ranks of a simulated node, 0 for the physical nodes
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return DATATYPE* the slice of the process (see Slice_offset) in the
+ * shared window: the input is read and sorted in place
+ */
+DATATYPE* Hier_setup(Hier_merge* h, size_t size, int node_size, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief Hierarchical merge of the sorted slices of the processes.
+ * The runs of a node are merged in the shared window, level by level, with
+ * no copies: at each level the ranks of the two merged runs split the output
+ * of the merge with co_rank. Then the leaders merge the lists of their nodes
+ * by the tree merge (see Merge_schedule) on leader_comm.
+ * 
+ * @param h the state returned by Hier_setup
+ * @return DATATYPE* on rank 0, the global sorted list (in the window)
+ */
+DATATYPE* Hier_merge_sort(Hier_merge* h);
+
+/**
+ * @brief Free the shared window and the communicators of the hierarchical merge.
+ * 
+ * @param h the state returned by Hier_setup
+ */
+void Hier_free(Hier_merge* h);
+
+#endif /* B5E1C7A3_8D24_4A6F_93B0_2F7C6E1D4A58 */
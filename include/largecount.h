@@ -0,0 +1,98 @@
+/**
+ * @file largecount.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for MPI transfers with more than INT_MAX elements
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef C2E8B4F7_5D13_4A6B_8F29_3E7A0D9C61B4
+#define C2E8B4F7_5D13_4A6B_8F29_3E7A0D9C61B4
+
+#include <stdint.h>
+#include <limits.h>
+#include <mpi.h>
+
+// MPI datatype matching size_t
+#if SIZE_MAX == ULONG_MAX
+#define MPI_SIZE_T MPI_UNSIGNED_LONG
+#else
+#define MPI_SIZE_T MPI_UNSIGNED_LONG_LONG
+#endif
+
+// Largest count passed as it is to MPI; bigger transfers use a derived datatype.
+// Can be lowered at compile time to exercise the large-count path on small inputs.
+#ifndef LARGE_COUNT_LIMIT
+#define LARGE_COUNT_LIMIT INT_MAX
+#endif
+
+/**
+ * @brief Committed datatype made of count contiguous elements of base,
+ * split in LARGE_COUNT_LIMIT-sized blocks plus a remainder when needed.
+ * To be released with MPI_Type_free().
+ * 
+ * @param count number of elements of base
+ * @param base the element datatype
+ * @return MPI_Datatype the new datatype
+ */
+MPI_Datatype Contiguous_large(size_t count, MPI_Datatype base);
+
+/**
+ * @brief Build the (type, count) pair describing count elements of base.
+ * Up to LARGE_COUNT_LIMIT elements the base type is returned unchanged;
+ * beyond, a Contiguous_large() type is returned with n = 1.
+ * 
+ * @param count number of elements of base
+ * @param base the element datatype
+ * @param n output: count to pass to MPI together with the returned type
+ * @return MPI_Datatype the type to pass to MPI, to be released with Free_large_type()
+ */
+MPI_Datatype Large_type(size_t count, MPI_Datatype base, int* n);
+
+/**
+ * @brief Release a type returned by Large_type() (no-op on the base type).
+ */
+void Free_large_type(MPI_Datatype* type, MPI_Datatype base);
+
+/* point to point transfers of any size */
+void Send_large(const void* buf, size_t count, MPI_Datatype base, int dest, int tag, MPI_Comm comm);
+void Recv_large(void* buf, size_t count, MPI_Datatype base, int source, int tag, MPI_Comm comm);
+
+/**
+ * @brief MPI_Alltoallv with size_t counts and displacements (in elements).
+ * When everything fits in an int the plain collective is used,
+ * otherwise the exchange is done with nonblocking point to point transfers.
+ */
+void Alltoallv_large(const void* sendbuf, const size_t* send_counts, const size_t* send_displs,
+                     void* recvbuf, const size_t* recv_counts, const size_t* recv_displs,
+                     MPI_Datatype base, MPI_Comm comm);
+
+#endif /* C2E8B4F7_5D13_4A6B_8F29_3E7A0D9C61B4 */
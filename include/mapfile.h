@@ -0,0 +1,74 @@
+/**
+ * @file mapfile.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the memory mapped input
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef E7B3A915_2C4F_4D86_9A1E_6F0C8B2D5A73
+#define E7B3A915_2C4F_4D86_9A1E_6F0C8B2D5A73
+
+#include <stddef.h>
+
+/**
+ * @brief A read only mapping of a range of a file: data points to the first
+ * byte of the range, base and length describe the page aligned mapping.
+ */
+typedef struct {
+  const void* data;
+  void* base;
+  size_t length;
+} Mapped_file;
+
+/**
+ * @brief Map length bytes of filename from offset, read only and shared: the
+ * pages are those of the page cache, so the processes of a node mapping the
+ * same file share a single copy of it. The pages are loaded at once
+ * (MAP_POPULATE where available) and the kernel is told that the access is
+ * sequential.
+ * 
+ * @param filename name of the file
+ * @param offset first byte of the range
+ * @param length bytes of the range (the file must hold them)
+ * @param map the mapping, to be released with Unmap_file
+ * @return int 0 on success, -1 on failure (errno is set)
+ */
+int Map_file(const char* filename, size_t offset, size_t length, Mapped_file* map);
+
+/**
+ * @brief Release a mapping of Map_file.
+ * 
+ * @param map the mapping
+ */
+void Unmap_file(Mapped_file* map);
+
+#endif /* E7B3A915_2C4F_4D86_9A1E_6F0C8B2D5A73 */
@@ -43,36 +43,83 @@
 
 #include "datatype.h"
 #include "utils.h"
+#include "largecount.h"
+#include "trace.h"
+#include "mapfile.h"
 
-// shall be changed accordingly
-// for example: (MPI_INT, int) or (MPI_DOUBLE, double)
-#define MPITYPE MPI_INT
+// default number of elements in each message of the pipelined tree merge
+#define PIPELINE_CHUNK 65536
+// receive buffers kept posted by the pipelined tree merge
+#define PIPELINE_DEPTH 4
+// default chunks of a slice read by the pipelined ingest (see Pipelined_ingest)
+#define INGEST_CHUNKS 8
+// bound on the levels of the tree merge (ceil(log2(n_rank)) for any int n_rank)
+#define MERGE_TREE_DEPTH 32
+
+/**
+ * @brief Position of a process in the tree merge (see Merge_schedule):
+ * the process receives from child[k] the slices of the ranks
+ * [child[k], child_end[k]), in this order, then sends the slices of
+ * [rank, end) to parent.
+ */
+typedef struct {
+  int parent;                          // -1 for rank 0
+  int n_children;
+  int child[MERGE_TREE_DEPTH];
+  int child_end[MERGE_TREE_DEPTH];
+  int end;                             // the subtree of the process is [rank, end)
+} Merge_tree;
 
 
 
-/* sort function and helpers */
-void quickSort(DATATYPE* a, int lo, int hi);
-int compare(const void* a_p, const void* b_p);
+/**
+ * @brief Body of the MPI sort for the key type DATATYPE, called by main
+ * with the key type selected by --dtype.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @return int exit status
+ */
+int sort_main(int argc, char* argv[]);
 
 /* Local functions */
-double init(DATATYPE* local_array, int local_size, int n_rank, int rank, char* filename, int version, MPI_Comm com);
-double init_local_sort(DATATYPE* local_array, int local_size, int n_rank, int rank, MPI_Comm com); 
-void Print_list(DATATYPE* local_array, int n);
-void Print_list_node(DATATYPE local_array[], int n, int local_size);
-void Merge(DATATYPE* local_array, DATATYPE* B, DATATYPE* C, int size);
+double init(DATATYPE* local_array, size_t size, int n_rank, int rank, char* filename, int version, MPI_Comm com);
+double write_output(DATATYPE* local_array, size_t local_size, int n_rank, int rank, const char* filename, int version, MPI_Comm com);
+double Read_elements(void* local_array, size_t size, MPI_Datatype elem_type, int n_rank, int rank, char* filename, int version, MPI_Comm com);
+double Write_elements(const void* local_array, size_t local_size, MPI_Datatype elem_type, int n_rank, int rank, const char* filename, int version, MPI_Comm com);
+double init_local_sort(DATATYPE* local_array, size_t local_size, int n_rank, MPI_Comm com); 
+double init_local_sort_from(const DATATYPE* in, DATATYPE* local_array, size_t local_size, int n_rank, MPI_Comm com);
+double Pipelined_ingest(DATATYPE* local_array, size_t size, int n_rank, int rank, char* filename, int version,
+                        size_t n_chunks, size_t chunk, MPI_Comm com, double* sort_time, double* hidden_time);
+double Map_input(Mapped_file* map, size_t size, int n_rank, int rank, const char* filename, MPI_Comm com);
+void local_sort(DATATYPE* local_array, size_t local_size);
+void local_sort_from(const DATATYPE* in, DATATYPE* out, size_t n);
+void Select_local_sort(int sort_type, int n_threads);
+void Print_list(DATATYPE* local_array, size_t n);
+void Print_list_node(DATATYPE local_array[], size_t n, size_t local_size);
+void Merge(DATATYPE* A, size_t na, DATATYPE* B, size_t nb, DATATYPE* C);
+void Merge_stream(DATATYPE* A, size_t na, DATATYPE* C, size_t nb, size_t chunk, int partner, MPI_Comm comm);
+size_t Slice_offset(size_t size, int rank, int n_rank);
+Merge_tree Merge_schedule(int rank, int n_rank);
 
 /* Functions involving communication */
-void Merge_sort(DATATYPE* local_array, int local_n, int my_rank, int p, MPI_Comm comm);
-void Print_global_list(DATATYPE* local_array, int local_n, int my_rank, int p, MPI_Comm comm);
+size_t Merge_buffer_size(size_t size, int my_rank, int p);
+int Slices_in_order(const DATATYPE* local_array, size_t size, int my_rank, int p, MPI_Comm comm);
+void Merge_sort(DATATYPE** local_array, size_t size, int my_rank, int p, MPI_Comm comm);
+void Merge_sort_pipelined(DATATYPE** local_array, size_t size, int my_rank, int p, size_t chunk, MPI_Comm comm);
+void Merge_sort_path(DATATYPE** local_array, size_t size, int my_rank, int p, MPI_Comm comm);
+void Print_global_list(DATATYPE* local_array, size_t local_n, int my_rank, int p, MPI_Comm comm);
+void Print_global_list_v(DATATYPE* local_array, size_t local_n, int my_rank, int p, MPI_Comm comm);
 
 
 // Macro for measuring MPI execution time 
 #define START_T(X) X = MPI_Wtime();
 
-// execute the sum of the times taken by each process
-#define END_T(end,start,comm,sum) do { \
+// record the phase in the trace of the process and execute the sum of the times
+// taken by each process (no barrier: a slow process shows in the trace, not in the sum)
+#define END_T(end,start,comm,sum,phase,bytes) do { \
     end = MPI_Wtime() - start; \
-    MPI_Barrier(comm); \
+    Trace_record(phase, -1, start, start + end, bytes); \
     sum = 0;  \
     MPI_Reduce(&end, &sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm); \
 }while(0);
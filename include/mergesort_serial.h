@@ -43,14 +43,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h> // for INT_MIN and INT_MAX
-#include <time.h> // for clock()
+#include <time.h> // for clock_gettime()
+
+// wall clock time in seconds (clock() would sum the CPU time of all the threads)
+static inline double wall_time(void){
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
 // macros for measuring time
-#define START_T(start)  start = clock()
-#define STOP_T(t)  t = (clock() - t)/CLOCKS_PER_SEC
+#define START_T(start)  start = wall_time()
+#define STOP_T(t)  t = wall_time() - t
+
+/**
+ * @brief Body of the serial sort for the key type DATATYPE, called by main
+ * with the key type selected by --dtype.
+ * 
+ * @param argc argument count
+ * @param argv argument vector
+ * @return int exit status
+ */
+int sort_main(int argc, char* argv[]);
+
+int read_file(char* filename, DATATYPE* array, size_t arraySize);
 
-int read_file(char* filename, DATATYPE* array, int arraySize);
+int write_file(const char* filename, DATATYPE* array, size_t arraySize);
 
-void printArray(DATATYPE *array, int arraySize);
+void printArray(DATATYPE *array, size_t arraySize);
 
 #endif /* F15EE0A8_AB33_42A0_AAAF_C6B4A6C041DC */
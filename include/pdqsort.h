@@ -0,0 +1,69 @@
+/**
+ * @file pdqsort.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for pattern-defeating quicksort
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef A7C4E19B_3D62_4F08_B5E7_2C9A1F6D8B35
+#define A7C4E19B_3D62_4F08_B5E7_2C9A1F6D8B35
+
+#include "datatype.h"
+#include <stddef.h>
+
+// ranges smaller than this are sorted by insertion sort
+#define PDQ_INSERTION_THRESHOLD 24
+// ranges larger than this take the pivot as the ninther (median of 3 medians of 3)
+#define PDQ_NINTHER_THRESHOLD 128
+// moves allowed to the insertion sort that checks an already partitioned range
+#define PDQ_PARTIAL_INSERTION_LIMIT 8
+// elements classified at a time by the block partition (offsets stored in a byte)
+#define PDQ_BLOCK_SIZE 64
+
+/**
+ * @brief Pattern-defeating quicksort (Orson Peters' pdqsort) of an array of DATATYPE,
+ * unstable and in place.
+ * 
+ * The pivot is the median of 3 (ninther on large ranges), the partition
+ * classifies blocks of PDQ_BLOCK_SIZE elements without branches, and a range
+ * whose pivot equals the element before it is partitioned in (== pivot, > pivot)
+ * so that runs of equal keys are done in one step. Small ranges are sorted by
+ * insertion sort; unbalanced partitions shuffle some elements and, after
+ * log2(n) of them, the range is sorted by heapsort.
+ * <a href="https://github.com/orlp/pdqsort">Code reference</a>
+ * 
+ * @param X Array to sort
+ * @param n Size of the array
+ */
+void pdq_sort(DATATYPE* X, size_t n);
+
+#endif /* A7C4E19B_3D62_4F08_B5E7_2C9A1F6D8B35 */
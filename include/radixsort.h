@@ -0,0 +1,77 @@
+/**
+ * @file radixsort.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for radix sort
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef D91A6E3C_4F27_4B85_9C1E_8A5D2F7B3E40
+#define D91A6E3C_4F27_4B85_9C1E_8A5D2F7B3E40
+
+#include "datatype.h"
+#include <stddef.h>
+
+// digit width of the passes on keys of at least 32 bits (smaller keys use 8 bit digits)
+#define RADIX_BITS 11
+// buckets of the MSD split up to this size are sorted by insertion sort
+#define RADIX_SMALL 64
+
+/**
+ * @brief Radix sort of an array of DATATYPE.
+ * 
+ * The keys are first mapped to unsigned integers with the same order
+ * (sign bit flipped for signed integers, all bits flipped for negative
+ * floating point numbers), then sorted with RADIX_BITS wide digits
+ * (8 bits for keys of 8 and 16 bits). All the digit histograms are
+ * computed in a single read pass, and the digits that are the same for
+ * every key are skipped. A single scatter on the most significant of the
+ * other digits splits the keys in buckets of a support buffer; each bucket
+ * is then sorted by LSD passes on the lower digits while it is in cache
+ * (insertion sort up to RADIX_SMALL keys), so the array is read and
+ * written only twice whatever the key size.
+ * 
+ * @param X Array to sort
+ * @param n Size of the array
+ */
+void radix_sort(DATATYPE* X, size_t n);
+
+/**
+ * @brief Out-of-place radix_sort: the n elements of in are sorted into X, the
+ * copy being the histogram pass (in may be X, or a mapped file).
+ * 
+ * @param in Array to sort (not modified when it is not X)
+ * @param X Destination of the sorted array
+ * @param n Size of the array
+ */
+void radix_sort_from(const DATATYPE* in, DATATYPE* X, size_t n);
+
+#endif /* D91A6E3C_4F27_4B85_9C1E_8A5D2F7B3E40 */
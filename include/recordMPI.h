@@ -0,0 +1,160 @@
+/**
+ * @file recordMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the sort of key + payload records
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef A4D92C6E_1B37_4F85_9E0A_7C3F5B8D2E61
+#define A4D92C6E_1B37_4F85_9E0A_7C3F5B8D2E61
+
+#include "mergeMPI.h"
+
+// local sort strategies of the records
+#define RECORD_SORT_AUTO   0 // direct up to RECORD_DIRECT_MAX bytes, index beyond
+#define RECORD_SORT_DIRECT 1 // merge sort moving the whole records
+#define RECORD_SORT_INDEX  2 // merge sort of (key, index) pairs, then a single permutation of the records
+
+// widest records sorted directly by RECORD_SORT_AUTO
+#define RECORD_DIRECT_MAX 32
+// runs sorted by insertion sort before the merge passes of the local sort
+#define RECORD_RUN 16
+
+// (key, index) pair of the index strategy
+typedef struct {
+  DATATYPE key;
+  size_t index;
+} Key_index;
+
+/**
+ * @brief Parallel sort of records of rec_size bytes, ordered by the DATATYPE
+ * key stored at key_offset bytes from the start of each record.
+ * 
+ * Each process reads size / n_rank records (see Read_elements) and sorts them.
+ * With RECORD_SORT_DIRECT the sorted records are merged on rank 0 by the
+ * tree merge (Record_merge_sort), which sends the records as a contiguous MPI
+ * datatype of rec_size bytes; with RECORD_SORT_INDEX only the sorted (key,
+ * index) pairs are merged and the records are moved once at the end (see
+ * Record_index_merge_sort). Rank 0 writes the result if out_filename is given.
+ * 
+ * @param filename name of the input file
+ * @param size number of records in the input file
+ * @param out_filename name of the output file (NULL: no output)
+ * @param rec_size bytes of a record
+ * @param key_offset offset of the key in the record
+ * @param strategy local sort strategy (RECORD_SORT_AUTO, RECORD_SORT_DIRECT or RECORD_SORT_INDEX)
+ * @param version read and write mode (see init)
+ * @param test_mode if set, rank 0 prints the sorted keys
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @param init_time output: mean time spent reading the input
+ * @param local_time output: mean time spent in the local sort
+ * @param merge_time output: on rank 0, max time over the processes spent in the merge
+ * @param write_time output: mean time spent writing the output
+ */
+void Record_sort(char* filename, size_t size, const char* out_filename, size_t rec_size, size_t key_offset,
+                 int strategy, int version, int test_mode, int rank, int n_rank, MPI_Comm comm,
+                 double* init_time, double* local_time, double* merge_time, double* write_time);
+
+/**
+ * @brief Stable local sort of n records by key.
+ * RECORD_SORT_DIRECT merge sorts the records themselves, RECORD_SORT_INDEX
+ * merge sorts (key, index) pairs and then moves each record once, following
+ * the cycles of the permutation.
+ * 
+ * @param records the records to sort
+ * @param n number of records
+ * @param rec_size bytes of a record
+ * @param key_offset offset of the key in the record
+ * @param strategy local sort strategy
+ */
+void Record_local_sort(char* records, size_t n, size_t rec_size, size_t key_offset, int strategy);
+
+/**
+ * @brief Tree merge of the sorted records of each process on rank 0 (see Merge_sort).
+ * 
+ * PRE: *local_records holds the slice of the process (see Slice_offset)
+ * in a buffer of Merge_buffer_size(size, rank, n_rank) records
+ * 
+ * @param local_records pointer to the sorted records of the process; at the end
+ * it points to the global sorted records (the buffer may have been swapped)
+ * @param size the number of records of the global list
+ * @param rec_size bytes of a record
+ * @param key_offset offset of the key in the record
+ * @param rec_type contiguous MPI datatype of a record
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ */
+void Record_merge_sort(char** local_records, size_t size, size_t rec_size, size_t key_offset,
+                       MPI_Datatype rec_type, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief Tree merge of the sorted (key, index) pairs of each process on rank 0
+ * (see Record_merge_sort), then every process sends its records to rank 0 in
+ * input order and rank 0 moves each of them once to its place: the payload is
+ * not copied at every level of the tree.
+ * 
+ * PRE: *pairs holds the pairs of the slice of the process sorted by key, with
+ * index the position of the record in the input, in a buffer of
+ * Merge_buffer_size(size, rank, n_rank) pairs; records holds the slice
+ * unsorted, in a buffer of size records on rank 0
+ * 
+ * @param pairs pointer to the sorted pairs of the process (the buffer may be
+ * swapped, the caller frees *pairs)
+ * @param records the records of the process; at the end, on rank 0, the global sorted records
+ * @param size the number of records of the global list
+ * @param rec_size bytes of a record
+ * @param rec_type contiguous MPI datatype of a record
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ */
+void Record_index_merge_sort(Key_index** pairs, char* records, size_t size, size_t rec_size,
+                             MPI_Datatype rec_type, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief Stable merge of two sorted arrays of records into out
+ * (on equal keys A comes first).
+ * 
+ * @param A first sorted array
+ * @param na records of A
+ * @param B second sorted array
+ * @param nb records of B
+ * @param out destination of na + nb records
+ * @param rec_size bytes of a record
+ * @param key_offset offset of the key in the record
+ */
+void Merge_records(const char* A, size_t na, const char* B, size_t nb, char* out, size_t rec_size, size_t key_offset);
+
+#endif /* A4D92C6E_1B37_4F85_9E0A_7C3F5B8D2E61 */
@@ -0,0 +1,70 @@
+/**
+ * @file runsort.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Adaptive natural merge sort for presorted inputs
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef E3A9C1F7_6B25_4D8E_A04C_9D17B3E5F286
+#define E3A9C1F7_6B25_4D8E_A04C_9D17B3E5F286
+
+#include "datatype.h"
+#include <stddef.h>
+
+// shorter natural runs are extended to this length by insertion sort
+#define RUN_MIN 32
+// consecutive wins of one run before the merge switches to galloping
+#define RUN_MIN_GALLOP 7
+// bound on the pending runs (their powers are strictly increasing, < 64)
+#define RUN_STACK 80
+
+/**
+ * @brief Adaptive natural merge sort (powersort) of an array of DATATYPE, stable.
+ * 
+ * The existing ascending runs, and the strictly descending ones (reversed), are
+ * detected in one scan; runs shorter than RUN_MIN are extended by insertion sort.
+ * Adjacent runs are merged in the order given by their powersort node power,
+ * so the merge tree is nearly optimal for the run lengths found. A merge is
+ * skipped when the runs are already in order; otherwise the parts of the runs
+ * already in place are found by galloping (exponential search) and the
+ * merge gallops whenever one run wins RUN_MIN_GALLOP times in a row.
+ * So a sorted input costs one scan, and almost sorted inputs little more.
+ * Inputs with natural runs shorter than RUN_MIN on average (counted in a first
+ * scan) are sorted by mergesort_rec instead.
+ * <a href="https://www.wild-inform.de/download/Munro-Wild-2018.pdf">Code reference</a>
+ * 
+ * @param X Array to sort
+ * @param n Size of the array
+ */
+void run_sort(DATATYPE* X, size_t n);
+
+#endif /* E3A9C1F7_6B25_4D8E_A04C_9D17B3E5F286 */
@@ -0,0 +1,99 @@
+/**
+ * @file samplesortMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for parallel sample sort
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef A7C3E5D1_2B94_4F86_9E0A_61D8B7C24F35
+#define A7C3E5D1_2B94_4F86_9E0A_61D8B7C24F35
+
+#include "mergeMPI.h"
+
+/**
+ * @brief Parallel sample sort (regular sampling): starts with a distributed
+ * collection of sorted lists, ends with every process owning a contiguous
+ * slice of the global sorted list (slices ordered by rank).
+ * 
+ * @param local_array pointer to the sorted array of the process; it is
+ * replaced by a newly allocated array holding the slice owned by the process
+ * @param local_n the size of the array
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return size_t the number of elements owned by the process after the sort
+ */
+size_t Sample_sort(DATATYPE** local_array, size_t local_n, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief A key and its position in the global list. Ordering the keys by
+ * (key, index) makes all of them distinct, so a run of equal keys can be
+ * split among the processes like any other range.
+ */
+typedef struct {
+  DATATYPE key;
+  size_t index;
+} Splitter;
+
+/**
+ * @brief Select n_rank-1 splitters from the sorted samples of the
+ * processes: n_rank regular samples are taken from the local ones of every
+ * process that has any, gathered on all of them and sorted; the splitters
+ * are taken at regular intervals in the sorted samples.
+ * 
+ * @param samples the local samples, sorted by (key, index)
+ * @param n_samples the number of local samples (0 for none)
+ * @param n_rank size of communicator
+ * @param splitters output array of n_rank-1 elements
+ * @param comm the communicator
+ */
+void Select_splitters(const Splitter* samples, size_t n_samples, int n_rank, Splitter* splitters, MPI_Comm comm);
+
+/**
+ * @brief Number of elements of the sorted array a, whose element i has
+ * position offset + i in the global list, not greater than the splitter s
+ * in the (key, index) order.
+ * 
+ * @param a the sorted array
+ * @param n the size of the array
+ * @param offset global position of a[0]
+ * @param s the splitter
+ * @return size_t the end of the elements up to s
+ */
+size_t Splitter_bound(const DATATYPE* a, size_t n, size_t offset, Splitter s);
+
+/**
+ * @brief (key, index) order of the splitters, for qsort.
+ */
+int Splitter_compare(const void* a, const void* b);
+
+#endif /* A7C3E5D1_2B94_4F86_9E0A_61D8B7C24F35 */
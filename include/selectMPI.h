@@ -0,0 +1,122 @@
+/**
+ * @file selectMPI.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the distributed selection of ranks, percentiles and top-k
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef F2A84C6D_9B17_4E35_A0C8_7D3E5B19F4A2
+#define F2A84C6D_9B17_4E35_A0C8_7D3E5B19F4A2
+
+#include "mergeMPI.h"
+
+// keys sampled across the processes at each narrowing step
+#define SELECT_SAMPLE 1024
+// below this many candidate keys the rest is gathered and sorted on rank 0
+#define SELECT_GATHER 65536
+
+/**
+ * @brief Parse the queries: a comma separated list of ranks (0 is the
+ * smallest key) and a comma separated list of percentiles in [0, 100],
+ * turned into ranks by the nearest-rank method. Exit with failure on an
+ * invalid entry.
+ * 
+ * @param ranks list of ranks, NULL for none
+ * @param percentiles list of percentiles, NULL for none
+ * @param size the number of keys
+ * @param k output: the ranks of the queries, in order (to be freed)
+ * @return size_t the number of queries
+ */
+size_t Query_ranks(const char* ranks, const char* percentiles, size_t size, size_t** k);
+
+/**
+ * @brief Key of rank k of the distributed list, without sorting it.
+ * 
+ * At each step rank 0 sorts a sample of SELECT_SAMPLE candidate keys, drawn
+ * from the processes in proportion to their candidates, and takes the two
+ * sample keys around the expected position of k as pivots (Floyd-Rivest).
+ * Every process partitions its candidates in (< low, [low, high], > high)
+ * and the part of rank k becomes the new candidates, so their number drops
+ * by about sqrt(SELECT_SAMPLE) / 2 at each step and the work is O(n) per
+ * process. When the candidates are at most SELECT_GATHER they are gathered
+ * and sorted on rank 0.
+ * 
+ * @param X the keys of the process, reordered by the partitions
+ * @param n the number of keys of the process
+ * @param size the number of keys of all the processes
+ * @param k the rank of the key, less than size
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return DATATYPE the key of rank k, on every process
+ */
+DATATYPE Select_kth(DATATYPE* X, size_t n, size_t size, size_t k, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief The k largest keys of the distributed list. Each process keeps
+ * its k largest keys in a min-heap, then the candidates are reduced along
+ * the merge tree (see Merge_schedule): a process merges the lists of its
+ * children and sends the k largest keys to its parent.
+ * 
+ * @param X the keys of the process
+ * @param n the number of keys of the process
+ * @param size the number of keys of all the processes
+ * @param k number of keys wanted
+ * @param top output on rank 0: the min(k, size) largest keys in ascending order
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return size_t the number of keys in top (on rank 0)
+ */
+size_t Top_k(const DATATYPE* X, size_t n, size_t size, size_t k, DATATYPE* top, int rank, int n_rank, MPI_Comm comm);
+
+/**
+ * @brief Answer the rank queries with Select_kth and the top-k query with
+ * Top_k on the slices of the processes. The time taken is returned.
+ * 
+ * @param local_array the slice of the process, reordered
+ * @param local_size the size of the slice
+ * @param size the number of keys of all the processes
+ * @param k the ranks of the queries (see Query_ranks)
+ * @param n_k the number of rank queries
+ * @param k_top number of the largest keys wanted, 0 for none
+ * @param answers output on rank 0: the keys of the n_k ranks followed
+ * by the min(k_top, size) largest keys in ascending order
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return double the mean time taken by the processes
+ */
+double Select_queries(DATATYPE* local_array, size_t local_size, size_t size, const size_t* k, size_t n_k,
+                      size_t k_top, DATATYPE* answers, int rank, int n_rank, MPI_Comm comm);
+
+#endif /* F2A84C6D_9B17_4E35_A0C8_7D3E5B19F4A2 */
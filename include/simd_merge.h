@@ -0,0 +1,88 @@
+/**
+ * @file simd_merge.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the merge kernels (SIMD with runtime dispatch)
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef B84F2C6E_1A57_4D93_8E3B_7C0F5A9D2E61
+#define B84F2C6E_1A57_4D93_8E3B_7C0F5A9D2E61
+
+#include "datatype.h"
+#include <stddef.h>
+
+/**
+ * @brief Merge two sorted arrays into out with the kernel selected for this CPU:
+ * a bitonic merge network on AVX-512, AVX2 or SSE4.1 (32 bit keys only) registers,
+ * the branchless scalar merge otherwise. Unsigned and floating point keys are
+ * mapped to signed integers of the same order while in the registers (a negative
+ * zero sorts before a positive one).
+ * The best kernel supported by the CPU is chosen at startup (see merge_kernel_select).
+ * Runs already in order (last of one <= first of the other) are just copied.
+ * 
+ * @param A first sorted array
+ * @param na size of A
+ * @param B second sorted array
+ * @param nb size of B
+ * @param out destination array of na + nb elements
+ */
+void merge_simd(const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb, DATATYPE* out);
+
+/**
+ * @brief Branchless scalar merge: the comparison selects the element
+ * with a conditional move and advances the indices arithmetically.
+ * 
+ * @param A first sorted array
+ * @param na size of A
+ * @param B second sorted array
+ * @param nb size of B
+ * @param out destination array of na + nb elements
+ */
+void merge_branchless(const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb, DATATYPE* out);
+
+/**
+ * @brief Select the merge kernel.
+ * 
+ * @param name "scalar", "sse4", "avx2", "avx512", or NULL/"auto" for the best one supported
+ * by the CPU; a kernel unknown, not supported by the CPU or not available for DATATYPE
+ * falls back to the best available one, with a warning. Call it before any merge runs
+ * (not from a parallel region)
+ * @return const char* the name of the selected kernel
+ */
+const char* merge_kernel_select(const char* name);
+
+/**
+ * @brief Name of the merge kernel in use
+ */
+const char* merge_kernel_name(void);
+
+#endif /* B84F2C6E_1A57_4D93_8E3B_7C0F5A9D2E61 */
@@ -0,0 +1,92 @@
+/**
+ * @file trace.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Function prototypes for the per-rank phase timeline
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#ifndef D8F2A6C4_1E73_4B95_8C0D_5A3E9F7B2C61
+#define D8F2A6C4_1E73_4B95_8C0D_5A3E9F7B2C61
+
+#include <stddef.h>
+#include <mpi.h>
+
+// events kept by each process: when the ring is full the oldest are overwritten
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 16384
+#endif
+
+/**
+ * @brief A phase of a process: [start, start + duration) in seconds since
+ * Trace_init, with the bytes it moved and its level in the merge tree (-1 for none).
+ */
+typedef struct {
+  const char* phase;  // static string
+  int level;
+  double start, duration;
+  size_t bytes;
+} Trace_event;
+
+/**
+ * @brief Start the trace of the process (collective on comm). Tracing is off
+ * when prefix is NULL: Trace_record then returns at once.
+ * 
+ * @param prefix prefix of the trace files (see Trace_finish), or NULL
+ * @param comm the communicator
+ */
+void Trace_init(const char* prefix, MPI_Comm comm);
+
+/**
+ * @brief Record a phase in the ring buffer of the process.
+ * 
+ * @param phase name of the phase (a static string)
+ * @param level level of the merge tree, -1 for none
+ * @param start MPI_Wtime() at the start of the phase
+ * @param end MPI_Wtime() at the end of the phase
+ * @param bytes bytes read, sent, received or merged in the phase
+ */
+void Trace_record(const char* phase, int level, double start, double end, size_t bytes);
+
+/**
+ * @brief Dump the trace (collective on comm) and release it: every process
+ * writes prefix.<rank>.csv, rank 0 writes prefix.json, the timeline of all the
+ * processes in the Chrome trace format (chrome://tracing, Perfetto).
+ * 
+ * @param comm the communicator
+ */
+void Trace_finish(MPI_Comm comm);
+
+// time a phase: TRACE_BEGIN(t) ... TRACE_END(t, "phase", level, bytes)
+#define TRACE_BEGIN(t) double t = MPI_Wtime();
+#define TRACE_END(t, phase, level, bytes) Trace_record(phase, level, t, MPI_Wtime(), bytes)
+
+#endif /* D8F2A6C4_1E73_4B95_8C0D_5A3E9F7B2C61 */
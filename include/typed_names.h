@@ -0,0 +1,103 @@
+/**
+ * @file typed_names.h
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Per key type names of the functions of the typed sources
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+#ifndef B6E2F0D7_94A3_4C1E_8F5B_3D7A2C9E1B84
+#define B6E2F0D7_94A3_4C1E_8F5B_3D7A2C9E1B84
+
+/*
+ * Every function with external linkage of a source compiled for each key type
+ * must be listed here: the source and its callers see the plain name, the
+ * linker sees one symbol per type (e.g. mergesort_rec_i64).
+ */
+
+/* mergeMPI.c, mergesort_serial.c, benchMPI.c, generateMPI.c */
+#define sort_main            TYPED(sort_main)
+#define bench_main           TYPED(bench_main)
+#define gen_main             TYPED(gen_main)
+#define init                 TYPED(init)
+#define write_output         TYPED(write_output)
+#define Read_elements        TYPED(Read_elements)
+#define Write_elements       TYPED(Write_elements)
+#define init_local_sort      TYPED(init_local_sort)
+#define init_local_sort_from TYPED(init_local_sort_from)
+#define Map_input            TYPED(Map_input)
+#define Pipelined_ingest     TYPED(Pipelined_ingest)
+#define local_sort           TYPED(local_sort)
+#define local_sort_from      TYPED(local_sort_from)
+#define Select_local_sort    TYPED(Select_local_sort)
+#define Print_global_list    TYPED(Print_global_list)
+#define Print_global_list_v  TYPED(Print_global_list_v)
+#define Print_list           TYPED(Print_list)
+#define Print_list_node      TYPED(Print_list_node)
+#define Merge_buffer_size    TYPED(Merge_buffer_size)
+#define Merge_sort           TYPED(Merge_sort)
+#define Merge_sort_pipelined TYPED(Merge_sort_pipelined)
+#define Merge_stream         TYPED(Merge_stream)
+#define Merge_sort_path      TYPED(Merge_sort_path)
+#define Slice_offset         TYPED(Slice_offset)
+#define Merge_schedule       TYPED(Merge_schedule)
+#define Slices_in_order      TYPED(Slices_in_order)
+#define Merge                TYPED(Merge)
+#define read_file            TYPED(read_file)
+#define write_file           TYPED(write_file)
+#define printArray           TYPED(printArray)
+
+/* samplesortMPI.c, externalMPI.c, recordMPI.c, hierMPI.c */
+#define Select_splitters     TYPED(Select_splitters)
+#define Splitter_bound       TYPED(Splitter_bound)
+#define Splitter_compare     TYPED(Splitter_compare)
+#define Sample_sort          TYPED(Sample_sort)
+#define External_sort        TYPED(External_sort)
+#define Record_sort          TYPED(Record_sort)
+#define Record_local_sort    TYPED(Record_local_sort)
+#define Record_merge_sort    TYPED(Record_merge_sort)
+#define Record_index_merge_sort TYPED(Record_index_merge_sort)
+#define Merge_records        TYPED(Merge_records)
+#define Hier_setup           TYPED(Hier_setup)
+#define Hier_merge_sort      TYPED(Hier_merge_sort)
+#define Hier_free            TYPED(Hier_free)
+
+/* compressMPI.c */
+#define Encode_run           TYPED(Encode_run)
+#define Decode_run           TYPED(Decode_run)
+#define Send_compressed      TYPED(Send_compressed)
+#define Merge_compressed_stream TYPED(Merge_compressed_stream)
+#define Merge_sort_compressed TYPED(Merge_sort_compressed)
+
+/* selectMPI.c */
+#define Query_ranks          TYPED(Query_ranks)
+#define Select_kth           TYPED(Select_kth)
+#define Top_k                TYPED(Top_k)
+#define Select_queries       TYPED(Select_queries)
+
+/* radixsort.c, pdqsort.c, runsort.c */
+#define radix_sort           TYPED(radix_sort)
+#define radix_sort_from      TYPED(radix_sort_from)
+#define pdq_sort             TYPED(pdq_sort)
+#define run_sort             TYPED(run_sort)
+
+/* utils.c */
+#define merge_rec            TYPED(merge_rec)
+#define mergesort_rec        TYPED(mergesort_rec)
+#define mergesort_rec_h      TYPED(mergesort_rec_h)
+#define mergesort_from_h     TYPED(mergesort_from_h)
+#define merge_ranges         TYPED(merge_ranges)
+#define co_rank              TYPED(co_rank)
+#define mergesort_par        TYPED(mergesort_par)
+#define mergesort_par_from   TYPED(mergesort_par_from)
+#define kway_merge           TYPED(kway_merge)
+
+/* simd_merge.c */
+#define merge_simd           TYPED(merge_simd)
+#define merge_branchless     TYPED(merge_branchless)
+#define merge_kernel_select  TYPED(merge_kernel_select)
+#define merge_kernel_name    TYPED(merge_kernel_name)
+
+#endif /* B6E2F0D7_94A3_4C1E_8F5B_3D7A2C9E1B84 */
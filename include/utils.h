@@ -38,40 +38,134 @@
 #define FDF65B0C_B221_4A62_8ABF_4B3AA35CA7F1
 
 #include "datatype.h"
+#include "simd_merge.h"
+#include "args.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>  // to check correctness of input
 #include <limits.h> // for INT_MIN and INT_MAX
+#include <stdint.h> // for SIZE_MAX
 
-int check_int_input(const char* par);
+// smallest sub-array sorted by a task of mergesort_par (smaller ones are sorted serially)
+#define MERGESORT_TASK_CUTOFF 16384
+// smallest merge split among the threads by mergesort_par
+#define PAR_MERGE_CUTOFF 262144
+// blocks sorted by the sorting network of mergesort_rec_h
+#define MERGESORT_BLOCK 8
+// bytes of a tile merged in cache by mergesort_rec_h (tile and support buffer fit the L2)
+#define MERGESORT_TILE_BYTES (256 * 1024)
+#define MERGESORT_TILE (MERGESORT_TILE_BYTES / (2 * sizeof(DATATYPE)))
+// runs merged together by each pass of mergesort_rec_h beyond the tile size (two levels of 2-way merges)
+#define MERGESORT_WAYS 4
+// output elements of each step of the 4-way merge (its two intermediate buffers fit the L2)
+#define MERGESORT_SEGMENT (MERGESORT_TILE / 2)
 
 /**
- * @brief merge function of Merge Sort.
+ * @brief merge function of Merge Sort: merges the two sorted halves of X into tmp
+ * with the merge kernel selected for the CPU (see merge_simd).
  * <a href="https://github.com/dreamcrash/StackOverflow-/blob/main/OpenMP/MergeSort/main.c">Code reference</a> 
  * 
  * @param X Array to merge
  * @param n Size of the array
- * @param tmp Support array
+ * @param tmp Destination array
  */
-void merge_rec(DATATYPE* restrict X, int n, DATATYPE* restrict tmp);
+void merge_rec(DATATYPE* restrict X, size_t n, DATATYPE* restrict tmp);
 
 /**
- * @brief Helper function of recursive serial Merge Sort.
+ * @brief Serial bottom-up Merge Sort.
+ * Blocks of MERGESORT_BLOCK elements are sorted by a sorting network, then
+ * merged in pairs one tile of MERGESORT_TILE elements at a time, and the
+ * sorted tiles are merged MERGESORT_WAYS at a time. Each pass swaps X and tmp
+ * as destination, and the blocks are sorted in the buffer that makes the
+ * last pass end in X. The result is stored in X.
  * 
  * @param X Array to sort
  * @param n Size of the array
- * @param tmp Support array
+ * @param tmp Support array of n elements (its content is overwritten)
  */
-void mergesort_rec_h(DATATYPE* restrict X, int n, DATATYPE* restrict tmp);
+void mergesort_rec_h(DATATYPE* restrict X, size_t n, DATATYPE* restrict tmp);
 
 /**
- * @brief Main function of recursive serial Merge Sort.
+ * @brief Out-of-place mergesort_rec_h: the n elements of in are sorted into X,
+ * the copy being fused with the first pass (in may be X, or read only memory
+ * such as a mapped file).
+ * 
+ * @param in Array to sort (not modified when it is not X)
+ * @param X Destination of the sorted array
+ * @param n Size of the array
+ * @param tmp Support array of n elements (its content is overwritten)
+ */
+void mergesort_from_h(const DATATYPE* in, DATATYPE* X, size_t n, DATATYPE* tmp);
+
+/**
+ * @brief Main function of serial Merge Sort (see mergesort_rec_h).
+ * 
+ * @param X Array to sort
+ * @param n Size of the array
+ */
+void mergesort_rec(DATATYPE* restrict X, size_t n);
+
+/**
+ * @brief Merge two sorted arrays into out (on equal keys A comes first)
+ * with the merge kernel selected for the CPU (see merge_simd).
+ * 
+ * @param A first sorted array
+ * @param na size of A
+ * @param B second sorted array
+ * @param nb size of B
+ * @param out destination array of na + nb elements
+ */
+void merge_ranges(const DATATYPE* restrict A, size_t na, const DATATYPE* restrict B, size_t nb, DATATYPE* restrict out);
+
+/**
+ * @brief Co-rank (merge path): how many elements of A are among the
+ * first d elements of the merge of A and B (on equal keys A comes first).
+ * The first d merged elements are then A[0..i) and B[0..d-i).
+ * 
+ * @param d position in the merged output (0 <= d <= na + nb)
+ * @param A first sorted array
+ * @param na size of A
+ * @param B second sorted array
+ * @param nb size of B
+ * @return size_t the number of elements taken from A
+ */
+size_t co_rank(size_t d, const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb);
+
+/**
+ * @brief Multithreaded Merge Sort (OpenMP tasks): the array is split
+ * recursively in tasks down to MERGESORT_TASK_CUTOFF elements, sorted by mergesort_rec_h,
+ * and the merges of the top levels (at least PAR_MERGE_CUTOFF elements)
+ * are split among the threads with co_rank.
+ * With one thread (or without OpenMP) it is mergesort_rec.
  * 
  * @param X Array to sort
  * @param n Size of the array
+ * @param n_threads number of threads
+ */
+void mergesort_par(DATATYPE* X, size_t n, int n_threads);
+
+/**
+ * @brief Out-of-place mergesort_par: the n elements of in are sorted into X
+ * (see mergesort_from_h).
+ * 
+ * @param in Array to sort (not modified when it is not X)
+ * @param X Destination of the sorted array
+ * @param n Size of the array
+ * @param n_threads number of threads
+ */
+void mergesort_par_from(const DATATYPE* in, DATATYPE* X, size_t n, int n_threads);
+
+/**
+ * @brief K-way merge of sorted runs through a binary min-heap
+ * on the heads of the runs.
+ * 
+ * @param runs the sorted runs
+ * @param lens the size of each run
+ * @param k number of runs
+ * @param out destination array, large enough for the sum of lens
  */
-void mergesort_rec(DATATYPE* restrict X, int n);
+void kway_merge(DATATYPE** runs, const size_t* lens, int k, DATATYPE* restrict out);
 
 
 #endif /* FDF65B0C_B221_4A62_8ABF_4B3AA35CA7F1 */
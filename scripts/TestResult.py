@@ -51,21 +51,20 @@ class TestResult:
 
     def convert_to_data(msg: str,is_parallel:bool):
         msg = "{}".format(msg.decode("utf-8")).replace('\n', '').split(';')
-        if not(len(msg) == 7 or len(msg) == 8 and is_parallel):
+        if not(len(msg) == 8 and is_parallel or len(msg) == 7 and not is_parallel):
             raise Exception("could not convert measures to valid data")
 
         if(is_parallel):
-            # compute_time (time to execute mergesort) = elapsed_time - read_time
-            compute_time = round(float(msg[4]) - float(msg[2]),6) # max 6 decimal digits 
+            # compute_time: the global merge timed by the program (max over the processes)
             return TestResult(
             size_arr=msg[0],
             thread_num=msg[1],
             read_t=msg[2],
-            compute=compute_time,
+            compute=msg[4],
             local_sort_time=msg[3],
-            real_time=msg[4],
-            user_time=msg[5],
-            sys_time=msg[6],
+            real_time=msg[5],
+            user_time=msg[6],
+            sys_time=msg[7],
             )
         else:
             return TestResult(
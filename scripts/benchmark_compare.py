@@ -0,0 +1,140 @@
+# Course: High Performance Computing 2021/2022
+#
+# Lecturer: Francesco Moscato    fmoscato@unisa.it
+#
+# Group:
+# Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+# Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+#
+# Copyright (C) 2021 - All Rights Reserved
+#
+# This file is part of Contest - OMP.
+#
+# Contest - OMP is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Contest - OMP is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Contest - OMP.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Throughput regression check: the benchmark driver sorts a fixed set of
+generated inputs, writing its repetitions in
+bench/Case_<sort + 1>/version_<v>/merge_<m>/size_<log2 n>/bench_<p>_<log2 n>.csv, then the
+median sort time (local sort plus merge phase, timed in process) of every
+configuration is compared with the same file of a baseline recorded by the
+benchmark driver with --record. The measures of generate_measures.py time the
+whole mpirun from outside, so they can not be a baseline.
+Exits with status 1 when a configuration is slower than the baseline by more
+than the threshold, with status 2 when the baseline has no measures of the
+benchmark driver.
+"""
+
+import argparse
+import csv
+import statistics
+import subprocess as sp
+import sys
+from pathlib import Path
+
+SIZES = (18, 20, 22)  # log2 of the input sizes
+SORT_TYPES = (0, 1)   # Case_1 and Case_2 of the baseline
+VERSION = 0
+PROCS = 4
+REPS = 10
+ELEM_SIZE = 4         # int32 keys
+BENCH_GLOB = 'bench/Case_*/version_*/merge_*/size_*/bench_*.csv'
+
+
+def run(command: list):
+    print(' '.join(command), flush=True)
+    sp.run(command, check=True, stdout=sp.DEVNULL)
+
+
+def sort_time(file_csv: Path) -> float:
+    """Median of local_sort_time + merge_phase_time of the repetitions in file_csv"""
+    with open(file_csv) as f:
+        rows = list(csv.DictReader(f, delimiter=';'))
+    if not rows or 'merge_phase_time' not in rows[0]:
+        sys.exit(f'{file_csv} is not a measure of the benchmark driver')
+    return statistics.median(float(r['local_sort_time']) + float(r['merge_phase_time']) for r in rows)
+
+
+def measure(args):
+    mpi = [args.mpiexec] + args.preflags.split() + [args.np_flag, str(args.procs)]
+    data_dir = Path(args.output) / Path('data')
+    data_dir.mkdir(parents=True, exist_ok=True)
+
+    for size in SIZES:
+        data = data_dir / Path(f'2_{size}')
+        if not data.exists():
+            run(mpi + [args.gen, str(data), str(2 ** size), '--dist=uniform', '--seed=0'])
+        run(mpi + [args.bench, str(data), str(2 ** size), '--sort=' + ','.join(map(str, SORT_TYPES)),
+                   f'--version={VERSION}', f'--reps={args.reps}', f'--measures={args.output}'])
+
+
+def check_baseline(args):
+    if not any(Path(args.baseline).glob(BENCH_GLOB)):
+        print(f'{args.baseline} has no measures of the benchmark driver: record them with --record '
+              '(make benchmark_baseline)', file=sys.stderr)
+        sys.exit(2)
+
+
+def compare(args) -> int:
+    regressions = 0
+    print('case;version;merge;size;processes;baseline_s;current_s;baseline_gb_per_s;current_gb_per_s;change;status')
+    for current in sorted(Path(args.output).glob(BENCH_GLOB)):
+        relative = current.relative_to(args.output)
+        baseline = Path(args.baseline) / relative
+        case, version, merge = relative.parts[1], relative.parts[2], relative.parts[3]
+        size = int(relative.parts[4][len('size_'):])
+        processes = current.stem.split('_')[1]
+        t = sort_time(current)
+        if not baseline.exists():
+            print(f'{case};{version};{merge};{size};{processes};;{t:.6f};;{(2 ** size) * ELEM_SIZE / t / 1e9:.3f};;no baseline')
+            continue
+        t0 = sort_time(baseline)
+        change = t0 / t - 1  # throughput change
+        status = 'ok'
+        if change < -args.threshold:
+            status = 'REGRESSION'
+            regressions += 1
+        print(f'{case};{version};{merge};{size};{processes};{t0:.6f};{t:.6f};{(2 ** size) * ELEM_SIZE / t0 / 1e9:.3f};'
+              f'{(2 ** size) * ELEM_SIZE / t / 1e9:.3f};{change * 100:+.1f}%;{status}')
+    return regressions
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='compare the sort throughput with a baseline')
+    parser.add_argument('--bench', required=True, help='benchmark driver (bench_mpi_<variant>)')
+    parser.add_argument('--gen', required=True, help='input generator (gen_input_<variant>)')
+    parser.add_argument('--baseline', required=True, help='baseline measures directory (recorded with --record)')
+    parser.add_argument('--output', help='directory of the new measures')
+    parser.add_argument('--threshold', type=float, default=0.10, help='tolerated throughput loss (default 0.10)')
+    parser.add_argument('--procs', type=int, default=PROCS)
+    parser.add_argument('--reps', type=int, default=REPS)
+    parser.add_argument('--mpiexec', default='mpiexec')
+    parser.add_argument('--np-flag', default='-n')
+    parser.add_argument('--preflags', default='', help='flags of mpiexec before the executable')
+    parser.add_argument('--compare-only', action='store_true', help='compare the measures already in --output')
+    parser.add_argument('--record', action='store_true', help='measure into --baseline, without comparing')
+    args = parser.parse_args()
+
+    if args.record:
+        args.output = args.baseline
+        measure(args)
+        sys.exit(0)
+    if args.output is None:
+        parser.error('--output is required unless --record is given')
+    check_baseline(args)
+    if not args.compare_only:
+        measure(args)
+    n = compare(args)
+    if n > 0:
+        print(f'{n} configurations slower than the baseline by more than {args.threshold * 100:.0f}%')
+        sys.exit(1)
@@ -108,7 +108,7 @@ def extract_csv(dict_data: dict, file_csv: Path, csv_header=None, delimiter=';',
         mean, std = stats.norm.fit(x_data)
         # 68,3% = P{ μ − 1,00 σ < X < μ + 1,00 σ }
         x_data = df[(df[col] < (mean + std)) & (df[col] > (mean - std))][col]
-        result = mean if np.mean(x_data) is np.NaN else np.mean(x_data)
+        result = mean if x_data.empty else np.mean(x_data)  # a constant column leaves nothing within σ
 
         if info > 1:
             print(f'{file_csv.name} - col: {col}', '>>> mean:', mean, 'std:', std, 'final:',
@@ -117,7 +117,8 @@ def extract_csv(dict_data: dict, file_csv: Path, csv_header=None, delimiter=';',
         dict_data[col].append((file_csv.name, result))
 
 
-def get_data(csv_header: list, directory: Path = None, file_re="", serial_re: str = '', info: int = 0) -> dict:
+def get_data(csv_header: list, directory: Path = None, file_re="", serial_re: str = '', info: int = 0,
+             min_files: int = 2) -> dict:
     directory = os.getcwd() if directory is None else directory
     data = {}  # 'data' maintain all collected data
 
@@ -128,7 +129,7 @@ def get_data(csv_header: list, directory: Path = None, file_re="", serial_re: st
         files = sorted([f for f in os.listdir(current_folder) if f.endswith(".csv") and re.match(file_re, f)],
                        key=natural_keys)
 
-        if len(files) < 2:
+        if len(files) < min_files:
             continue
 
         data_folder = {}  # 'data' maintain processed data from csv files in a folder
@@ -173,10 +174,11 @@ if __name__ == '__main__':
     WORKLOAD_EXP = (16, 18, 19, 20)
     PROCS = (0, 2, 4, 8, 16)
     VERSIONS = (0, 1, 2, 3)
-    CASES = 2
+    CASES = 3
 
     RE_CSV = "(mpi_[0-9]+|serial)_[0-9]+"
     RE_SEQ = "serial_[0-9]+"
+    RE_BENCH = "bench_([0-9]+)_[0-9]+"
 
     opts = [opt for opt in sys.argv[1:] if opt.startswith("-")]
     args = [arg for arg in sys.argv[1:] if not arg.startswith("-")]
@@ -199,6 +201,8 @@ if __name__ == '__main__':
     measure_source = []
     for case in range(1, CASES + 1):
         tmp = base_dir / 'measures' / f'Case_{case}'
+        if not tmp.exists():
+            continue
         for folder in os.listdir(tmp):
             measure_source.append(tmp / folder)
     
@@ -274,3 +278,39 @@ if __name__ == '__main__':
                 outputFileName = 'table_{}_{}_{}+{}.csv'.format(base_output_name, folder, targetColumn, toSumColumn)
 
             make_table(table, filename=dir / outputFileName, img=True, save=True, print_table=False)
+
+    # repetitions of the benchmark driver (bench_mpi --measures=<measures dir>): timed in process and
+    # without a serial run, so tabled apart, with the speedup over the run with the fewest processes
+    bench_info = "size;processes;read_time;local_sort_time;merge_phase_time;total_time;user;sys".split(';')
+    bench_source = sorted((base_dir / 'measures' / 'bench').glob('Case_*/version_*/merge_*'),
+                          key=lambda p: natural_keys(str(p)))
+
+    for move_on in bench_source:
+        print(Fore.YELLOW + "Working on dir:", move_on, end='')
+        print(Style.RESET_ALL)
+
+        base_output_name = f"bench_{move_on.parent.parent.name.lower().replace('_','')}_" \
+                           f"{move_on.parent.name.replace('_','')}_{move_on.name.replace('_','')}"
+
+        print("Data extraction... ", end="")
+        data = get_data(bench_info, directory=move_on, file_re=RE_BENCH, min_files=1)
+        print("DONE")
+
+        for folder in data.keys():
+            print('>>', folder)
+            d = data[folder]
+            procs = [int(re.match(RE_BENCH, name).group(1)) for name, _ in d['total_time']]
+
+            table = []
+            header_table = ['Process', 'Read time', 'Local sort', 'Merge phase', 'Total', 'User', 'Sys',
+                            f'Speedup over {procs[0]}', 'Efficiency']
+            table.append(header_table)
+            for j in range(len(procs)):
+                speedup, eff = compute_speedup(d['total_time'][0][1], d['total_time'][j][1], procs[j] / procs[0])
+                row = [procs[j], '%.5f' % d['read_time'][j][1], '%.5f' % d['local_sort_time'][j][1],
+                       '%.5f' % d['merge_phase_time'][j][1], '%.5f' % d['total_time'][j][1],
+                       '%.5f' % d['user'][j][1], '%.5f' % d['sys'][j][1], '%.5f' % speedup, '%.5f' % eff]
+                table.append(row)
+
+            outputFileName = 'table_{}_{}.csv'.format(base_output_name, folder)
+            make_table(table, filename=move_on / folder / outputFileName, img=True, save=True, print_table=False)
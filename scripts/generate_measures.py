@@ -37,10 +37,12 @@ INPUT_SIZE_LIST = (2 ** 16, 2 ** 18, 2 ** 19, 2 ** 20)
 PROCS = (0, 2, 4, 8, 16)  # 1 not considered
 MSRS = 100  # Number of measures taken
 VERSIONS = (0, 1, 2, 3)
-CASES = 2  # 0 is with quicksort as local sort algorithm, 1 mergesort 
+CASES = 3  # local sort algorithm: 0 mergesort, 1 quicksort, 2 radix sort
+VARIANT = 'O0'  # build variant measured (O0, O2, O3, LTO, PGO)
 
 CASE_ONE_PATH = DST_FOLDER / Path("Case_1")
 CASE_TWO_PATH = DST_FOLDER / Path("Case_2")
+CASE_THREE_PATH = DST_FOLDER / Path("Case_3")
 
 
 def create_dir_if_not_exists(dir_path: Path):
@@ -68,18 +70,20 @@ def generate_measures():
     create_dir_if_not_exists(DST_FOLDER)
     create_dir_if_not_exists(CASE_ONE_PATH)
     create_dir_if_not_exists(CASE_TWO_PATH)
+    create_dir_if_not_exists(CASE_THREE_PATH)
 
-    executables = get_files_in_dir(SRC_FOLDER, with_sort=True)
     inputs = get_files_in_dir(INPUT_FILES_PATH)
 
-    mpi_executable = executables[0]  # first half CASES are mpi execs
-    serial_executable = executables[1]  # second half CASES are serial execs
+    mpi_executable = f"merge_mpi_{VARIANT}"  # first half CASES are mpi execs
+    serial_executable = f"merge_serial_{VARIANT}"  # second half CASES are serial execs
 
     for case in range(CASES):  # for each case
         if case == 0:
             case_path = CASE_ONE_PATH
-        else:
+        elif case == 1:
             case_path = CASE_TWO_PATH
+        else:
+            case_path = CASE_THREE_PATH
 
         exe_serial_path = SRC_FOLDER / Path(serial_executable)
         exe_mpi_path = SRC_FOLDER / Path(mpi_executable)
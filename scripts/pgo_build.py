@@ -0,0 +1,94 @@
+# Course: High Performance Computing 2021/2022
+#
+# Lecturer: Francesco Moscato    fmoscato@unisa.it
+#
+# Group:
+# Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+# Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+#
+# Copyright (C) 2021 - All Rights Reserved
+#
+# This file is part of Contest - OMP.
+#
+# Contest - OMP is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Contest - OMP is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Contest - OMP.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Two stage profile guided build: the build tree BUILD is configured with
+PGO_STAGE=generate, the instrumented executables sort the generated training
+inputs, then the same tree is configured with PGO_STAGE=use (the object paths
+do not change, so the profiles are found) and the optimized executables
+merge_mpi_PGO, merge_serial_PGO, bench_mpi_PGO and gen_input_PGO are copied in
+OUTPUT.
+"""
+
+import argparse
+import shutil
+import subprocess as sp
+from pathlib import Path
+
+TRAIN_SIZE = 2 ** 20
+TRAIN_PROCS = 4
+TRAIN_DTYPES = ('int32', 'double')
+TRAIN_DISTS = ('uniform', 'sorted', 'nearly', 'zipf', 'few')
+SORT_TYPES = (0, 1, 2, 3)   # mergesort, quicksort, radix sort, run-adaptive sort
+MERGE_TYPES = (0, 1, 2, 3, 4)
+EXECUTABLES = ('merge_mpi_PGO', 'merge_serial_PGO', 'bench_mpi_PGO', 'gen_input_PGO')
+
+
+def run(command: list):
+    print(' '.join(command), flush=True)
+    sp.run(command, check=True, stdout=sp.DEVNULL)
+
+
+def build(args, stage: str):
+    run(['cmake', '-S', args.source, '-B', args.build, f'-DPGO_STAGE={stage}', f'-DCMAKE_C_COMPILER={args.c_compiler}'])
+    run(['cmake', '--build', args.build, '-j'] + [f'--target={exe}' for exe in EXECUTABLES])
+
+
+def train(args):
+    bin_dir = Path(args.build) / Path('executables')
+    data_dir = Path(args.build) / Path('train_data')
+    data_dir.mkdir(exist_ok=True)
+    mpi = [args.mpiexec] + args.preflags.split() + [args.np_flag, str(TRAIN_PROCS)]
+
+    for dtype in TRAIN_DTYPES:
+        for dist in TRAIN_DISTS:
+            data = str(data_dir / Path(f'{dtype}_{dist}'))
+            run(mpi + [str(bin_dir / 'gen_input_PGO'), data, str(TRAIN_SIZE), f'--dist={dist}', f'--dtype={dtype}'])
+            run([str(bin_dir / 'merge_serial_PGO'), data, str(TRAIN_SIZE), f'--dtype={dtype}'])
+            # every local sort with the default merge, every merge with the default local sort
+            for sort in SORT_TYPES:
+                run(mpi + [str(bin_dir / 'merge_mpi_PGO'), data, str(TRAIN_SIZE), '0', str(sort), f'--dtype={dtype}'])
+            for merge in MERGE_TYPES[1:]:
+                run(mpi + [str(bin_dir / 'merge_mpi_PGO'), data, str(TRAIN_SIZE), '0', '0', f'--merge={merge}', f'--dtype={dtype}'])
+            run(mpi + [str(bin_dir / 'bench_mpi_PGO'), data, str(TRAIN_SIZE), '--warmup=0', '--reps=1', f'--dtype={dtype}'])
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='profile guided build of the sort executables')
+    parser.add_argument('--source', required=True, help='source directory')
+    parser.add_argument('--build', required=True, help='build directory of the profile guided tree')
+    parser.add_argument('--output', required=True, help='directory of the optimized executables')
+    parser.add_argument('--c-compiler', default='gcc', help='compiler of the profile guided tree (GCC profile flags)')
+    parser.add_argument('--mpiexec', default='mpiexec')
+    parser.add_argument('--np-flag', default='-n')
+    parser.add_argument('--preflags', default='', help='flags of mpiexec before the executable')
+    args = parser.parse_args()
+
+    shutil.rmtree(Path(args.build) / Path('profiles'), ignore_errors=True)  # stale profiles of older sources
+    build(args, 'generate')
+    train(args)
+    build(args, 'use')
+    Path(args.output).mkdir(parents=True, exist_ok=True)
+    for exe in EXECUTABLES:
+        shutil.copy2(Path(args.build) / Path('executables') / Path(exe), Path(args.output) / Path(exe))
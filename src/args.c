@@ -0,0 +1,107 @@
+/**
+ * @file args.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Command line parsing, shared by all the key types
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#include "../include/args.h"
+
+/**
+ * @brief Check if the string parameter
+ *  is a valid non-negative integer and convert it. 
+ * If is invalid exit with failure
+ * @param par string to be checked and converted
+ * @return int The integer converted from the string
+ */
+int check_int_input(const char* par){
+    /**
+     * from https://stackoverflow.com/questions/9748393/how-can-i-get-argv-as-int
+     * answer of https://stackoverflow.com/users/1201863/luc
+     */
+    char* p;
+    errno = 0; /*not 'int errno', because the '#include' already defined it*/
+    long arg = strtol(par, &p, 10);
+    if (*p != '\0' || errno != 0) {
+        fprintf(stderr,"not valid argument");
+        exit(EXIT_FAILURE); 
+    }
+    if (arg < INT_MIN || arg > INT_MAX) { /*if exceed the representation of int*/
+        fprintf(stderr,"argument exceed representation");
+        exit(EXIT_FAILURE);
+    }
+    int val = arg; /*#val now contains the size to be read*/
+    if(val < 0){
+        fprintf(stderr,"negative values not allowed");
+        exit(EXIT_FAILURE);
+    }
+    return val;
+}
+
+size_t check_size_input(const char* par, size_t elem_size){
+    char* p;
+    errno = 0;
+    if (*par == '-') {
+        fprintf(stderr,"negative values not allowed");
+        exit(EXIT_FAILURE);
+    }
+    unsigned long long arg = strtoull(par, &p, 10);
+    if (*p != '\0' || errno != 0) {
+        fprintf(stderr,"not valid argument");
+        exit(EXIT_FAILURE);
+    }
+    if (arg > SIZE_MAX / elem_size) { /*the array would not be addressable*/
+        fprintf(stderr,"argument exceed representation");
+        exit(EXIT_FAILURE);
+    }
+    return (size_t) arg;
+}
+
+int count_positional(int argc, char* argv[]){
+    int i = 1;
+    while (i < argc && strncmp(argv[i], "--", 2) != 0)
+        i++;
+    return i;
+}
+
+const char* get_opt(int argc, char* argv[], const char* name){
+    size_t len = strlen(name);
+    for (int i = 1; i < argc; i++){
+        if (strncmp(argv[i], "--", 2) == 0 && strncmp(argv[i] + 2, name, len) == 0){
+            if (argv[i][2 + len] == '=')
+                return argv[i] + 3 + len;
+            if (argv[i][2 + len] == '\0')
+                return "1"; // flag without value
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file benchMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief In-process benchmark of the sort configurations with robust statistics
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/benchMPI.h"
+#include "../include/samplesortMPI.h"
+#include "../include/hierMPI.h"
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/resource.h> // for getrusage()
+#include <sys/stat.h>     // for mkdir()
+
+static const char* PHASE_NAMES[BENCH_PHASES] = { "read", "local_sort", "merge", "total" };
+
+// a configuration of the benchmark (version -1: the input loaded once is copied)
+typedef struct {
+  int sort, merge, version, threads;
+  size_t chunk;
+} Bench_config;
+
+// parse a list of values "a,b,c" (def when opt is NULL), return its length
+static int parse_list(const char* opt, size_t* values, size_t def){
+  char buf[1024], *tok, *save;
+  int n = 0;
+
+  if (opt == NULL) {
+    values[0] = def;
+    return 1;
+  }
+  snprintf(buf, sizeof(buf), "%s", opt);
+  for (tok = strtok_r(buf, ",", &save); tok != NULL && n < BENCH_MAX_LIST; tok = strtok_r(NULL, ",", &save))
+    values[n++] = check_size_input(tok, 1);
+  return n;
+}
+
+static int compare_double(const void* a, const void* b){
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+// p-th percentile of the sorted samples (linear interpolation)
+static double percentile(const double* sorted, int n, double p){
+  double pos = p * (n - 1);
+  int i = (int) pos;
+  if (i >= n - 1)
+    return sorted[n - 1];
+  return sorted[i] + (pos - i) * (sorted[i + 1] - sorted[i]);
+}
+
+// two sided 97.5% quantile of the Student t distribution with df degrees of freedom
+static double t_quantile(int df){
+  static const double t[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                              2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                              2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+  if (df < 1)
+    return NAN;
+  return (df <= 30) ? t[df - 1] : 1.96;
+}
+
+// mkdir -p of the directories of path (the last component is a file)
+static void make_dirs(const char* path){
+  char buf[4096];
+
+  snprintf(buf, sizeof(buf), "%s", path);
+  for (char* p = buf + 1; *p; p++)
+    if (*p == '/') {
+      *p = '\0';
+      if (mkdir(buf, 0755) != 0 && errno != EEXIST)
+        fprintf(stderr, "cannot create %s\n", buf);
+      *p = '/';
+    }
+}
+
+/**
+ * @brief One repetition of a configuration: the time of every phase is the
+ * slowest process, on rank 0 (times[BENCH_PHASES] plus user and sys CPU time
+ * summed on all the processes).
+ */
+static void run_once(const Bench_config* c, const DATATYPE* input, size_t size, char* filename,
+                     int rank, int n_rank, MPI_Comm comm, double* times, double* cpu){
+  size_t local_size = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  double t[BENCH_PHASES], local_cpu[2];
+  struct rusage r0, r1;
+  Hier_merge hier;
+  DATATYPE* array;
+
+  if (c->merge == 3)
+    array = Hier_setup(&hier, size, 0, rank, n_rank, comm);
+  else {
+    size_t cap = (c->merge == 1 || c->merge == 4) ? local_size : Merge_buffer_size(size, rank, n_rank);
+    array = malloc((cap > 0 ? cap : 1) * sizeof(DATATYPE));
+  }
+  if (c->version < 0)
+    memcpy(array, input, local_size * sizeof(DATATYPE));
+  Select_local_sort(c->sort, c->threads);
+
+  MPI_Barrier(comm);
+  getrusage(RUSAGE_SELF, &r0);
+  double t0 = MPI_Wtime();
+  if (c->version >= 0)
+    init(array, size, n_rank, rank, filename, c->version, comm);
+  double t1 = MPI_Wtime();
+  local_sort(array, local_size);
+  double t2 = MPI_Wtime();
+  if (c->merge == 1)
+    Sample_sort(&array, local_size, rank, n_rank, comm);
+  else if (c->merge == 2)
+    Merge_sort_pipelined(&array, size, rank, n_rank, c->chunk, comm);
+  else if (c->merge == 3)
+    Hier_merge_sort(&hier);
+  else if (c->merge == 4)
+    Merge_sort_path(&array, size, rank, n_rank, comm);
+  else
+    Merge_sort(&array, size, rank, n_rank, comm);
+  double t3 = MPI_Wtime();
+  getrusage(RUSAGE_SELF, &r1);
+
+  t[BENCH_READ] = t1 - t0;
+  t[BENCH_SORT] = t2 - t1;
+  t[BENCH_MERGE] = t3 - t2;
+  t[BENCH_TOTAL] = t3 - t0;
+  local_cpu[0] = (r1.ru_utime.tv_sec - r0.ru_utime.tv_sec) + (r1.ru_utime.tv_usec - r0.ru_utime.tv_usec) * 1e-6;
+  local_cpu[1] = (r1.ru_stime.tv_sec - r0.ru_stime.tv_sec) + (r1.ru_stime.tv_usec - r0.ru_stime.tv_usec) * 1e-6;
+  MPI_Reduce(t, times, BENCH_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(local_cpu, cpu, 2, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (c->merge == 3)
+    Hier_free(&hier);
+  else
+    free(array);
+}
+
+int bench_main(int argc, char* argv[]){
+  int rank, n_rank;
+  MPI_Comm comm;
+  size_t sorts[BENCH_MAX_LIST], merges[BENCH_MAX_LIST], versions[BENCH_MAX_LIST], chunks[BENCH_MAX_LIST];
+  int n_sorts, n_merges, n_versions, n_chunks;
+
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided); // only the main thread calls MPI
+  comm = MPI_COMM_WORLD;
+  MPI_Comm_size(comm, &n_rank);
+  MPI_Comm_rank(comm, &rank);
+
+  if (count_positional(argc, argv) < 3){
+    if (rank == 0)
+      fprintf(stderr,"Usage:\n\t%s [input_fileName] [inputSize] [--warmup=runs (default = BENCH_WARMUP)] [--reps=repetitions (default = BENCH_REPS)]"
+                     " [--sort=SORT TYPE list (default = 0)] [--merge=MERGE TYPE list (default = 0)] [--version=VERSION list (default = input loaded once)]"
+                     " [--chunk=pipeline chunk list (default = PIPELINE_CHUNK)] [--threads=local sort threads (default = 1)]"
+                     " [--kernel=merge kernel scalar,sse4,avx2,avx512 (default = auto)] [--measures=dir of the repetitions (dir/bench/Case_<sort + 1>/version_<v>/merge_<m>[_chunk_<c>]/size_<log2 n>/bench_<p>_<log2 n>.csv)]"
+                     " [--dtype=key type int32,int64,uint64,float,double (default = int32)]\n",argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  char* filename = argv[1];
+  size_t size = check_size_input(argv[2], sizeof(DATATYPE));
+  const char* opt = get_opt(argc, argv, "warmup");
+  int warmup = (opt != NULL) ? check_int_input(opt) : BENCH_WARMUP;
+  opt = get_opt(argc, argv, "reps");
+  int reps = (opt != NULL) ? check_int_input(opt) : BENCH_REPS;
+  opt = get_opt(argc, argv, "threads");
+  int threads = (opt != NULL) ? check_int_input(opt) : 1;
+  const char* measures = get_opt(argc, argv, "measures");
+  merge_kernel_select(get_opt(argc, argv, "kernel"));
+  n_sorts = parse_list(get_opt(argc, argv, "sort"), sorts, 0);
+  n_merges = parse_list(get_opt(argc, argv, "merge"), merges, 0);
+  n_chunks = parse_list(get_opt(argc, argv, "chunk"), chunks, PIPELINE_CHUNK);
+  opt = get_opt(argc, argv, "version");
+  n_versions = parse_list(opt, versions, 0);
+  int loaded_once = (opt == NULL);
+  if (reps < 1)
+    reps = 1;
+
+  // the input is read once; the configurations with a VERSION read it again
+  size_t local_size = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  DATATYPE* input = malloc((local_size > 0 ? local_size : 1) * sizeof(DATATYPE));
+  init(input, size, n_rank, rank, filename, 0, comm);
+
+  double* samples = malloc((size_t) reps * (BENCH_PHASES + 2) * sizeof(double));
+  double* sorted = malloc(reps * sizeof(double));
+  double bytes = (double) size * sizeof(DATATYPE);
+  int size_log2 = 0;
+  while (size_log2 < 63 && ((size_t) 1 << (size_log2 + 1)) <= size)
+    size_log2++;
+
+  if (rank == 0)
+    printf("dtype;size;processes;sort;merge;version;chunk;threads;phase;reps;median;p5;p95;mean;ci95_low;ci95_high;gb_per_s\n");
+
+  for (int s = 0; s < n_sorts; s++)
+  for (int m = 0; m < n_merges; m++)
+  for (int v = 0; v < n_versions; v++)
+  for (int k = 0; k < n_chunks; k++) {
+    Bench_config c = { (int) sorts[s], (int) merges[m], loaded_once ? -1 : (int) versions[v], threads, chunks[k] };
+    if (c.merge != 2) { // the chunk only matters to the pipelined merge
+      if (k > 0)
+        continue;
+      c.chunk = 0;
+    }
+
+    for (int i = 0; i < warmup + reps; i++) {
+      double times[BENCH_PHASES], cpu[2];
+      run_once(&c, input, size, filename, rank, n_rank, comm, times, cpu);
+      if (i >= warmup && rank == 0) {
+        memcpy(samples + (size_t)(i - warmup) * (BENCH_PHASES + 2), times, sizeof(times));
+        memcpy(samples + (size_t)(i - warmup) * (BENCH_PHASES + 2) + BENCH_PHASES, cpu, sizeof(cpu));
+      }
+    }
+    if (rank != 0)
+      continue;
+
+    for (int p = 0; p < BENCH_PHASES; p++) {
+      double mean = 0, var = 0;
+      if (p == BENCH_READ && c.version < 0)
+        continue;
+      for (int i = 0; i < reps; i++) {
+        sorted[i] = samples[(size_t) i * (BENCH_PHASES + 2) + p];
+        mean += sorted[i];
+      }
+      mean /= reps;
+      for (int i = 0; i < reps; i++)
+        var += (sorted[i] - mean) * (sorted[i] - mean);
+      double half = (reps > 1) ? t_quantile(reps - 1) * sqrt(var / (reps - 1) / reps) : NAN;
+      qsort(sorted, reps, sizeof(double), compare_double);
+      double median = percentile(sorted, reps, 0.5);
+
+      printf("%s;%zu;%d;%d;%d;%d;%zu;%d;%s;%d;%.6f;%.6f;%.6f;%.6f;%.6f;%.6f;%.3f\n",
+             DATATYPE_NAME, size, n_rank, c.sort, c.merge, c.version, c.chunk, c.threads,
+             PHASE_NAMES[p], reps, median, percentile(sorted, reps, 0.05), percentile(sorted, reps, 0.95),
+             mean, mean - half, mean + half, bytes / median / 1e9);
+    }
+
+    // the repetitions in the layout of generate_measures.py, but under bench/, with a merge_<m>
+    // level and their own header: the times are taken in process, so they are not mixed with those
+    if (measures != NULL) {
+      char path[4096], merge[64];
+      if (c.merge == 2)
+        snprintf(merge, sizeof(merge), "merge_%d_chunk_%zu", c.merge, c.chunk);
+      else
+        snprintf(merge, sizeof(merge), "merge_%d", c.merge);
+      snprintf(path, sizeof(path), "%s/bench/Case_%d/version_%d/%s/size_%d/bench_%d_%d.csv",
+               measures, c.sort + 1, (c.version < 0) ? 0 : c.version, merge, size_log2, n_rank, size_log2);
+      make_dirs(path);
+      FILE* f = fopen(path, "w");
+      if (f == NULL)
+        fprintf(stderr, "cannot write %s\n", path);
+      else {
+        fprintf(f, "size;processes;read_time;local_sort_time;merge_phase_time;total_time;user;sys\n");
+        for (int i = 0; i < reps; i++) {
+          const double* r = samples + (size_t) i * (BENCH_PHASES + 2);
+          fprintf(f, "%zu;%d;%.6f;%.6f;%.6f;%.6f;%.6f;%.6f\n", size, n_rank, r[BENCH_READ], r[BENCH_SORT],
+                  r[BENCH_MERGE], r[BENCH_TOTAL], r[BENCH_PHASES], r[BENCH_PHASES + 1]);
+        }
+        fclose(f);
+      }
+    }
+    fflush(stdout);
+  }
+
+  free(samples);
+  free(sorted);
+  free(input);
+  MPI_Finalize();
+  return EXIT_SUCCESS;
+}
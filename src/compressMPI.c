@@ -0,0 +1,233 @@
+/**
+ * @file compressMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Tree merge with delta + varint encoded messages
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/compressMPI.h"
+#include <string.h>
+
+// unsigned integer of the size of a key
+#if DATATYPE_ID == DT_INT32 || DATATYPE_ID == DT_FLOAT
+typedef uint32_t Key_bits;
+#else
+typedef uint64_t Key_bits;
+#endif
+
+#define KEY_IS_FLOAT (DATATYPE_ID == DT_FLOAT || DATATYPE_ID == DT_DOUBLE)
+#define KEY_IS_SIGNED (DATATYPE_ID != DT_UINT64)
+
+// order preserving map of a key to an unsigned integer (as radix_sort)
+static inline Key_bits to_bits(DATATYPE x){
+  const Key_bits sign = (Key_bits)1 << (sizeof(Key_bits) * 8 - 1);
+  Key_bits u;
+  memcpy(&u, &x, sizeof(u));
+  if (KEY_IS_FLOAT)
+    return (u & sign) ? (Key_bits)~u : (Key_bits)(u ^ sign);
+  return KEY_IS_SIGNED ? (Key_bits)(u ^ sign) : u;
+}
+
+static inline DATATYPE from_bits(Key_bits u){
+  const Key_bits sign = (Key_bits)1 << (sizeof(Key_bits) * 8 - 1);
+  DATATYPE x;
+  if (KEY_IS_FLOAT)
+    u = (u & sign) ? (Key_bits)(u ^ sign) : (Key_bits)~u;
+  else if (KEY_IS_SIGNED)
+    u ^= sign;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+size_t Encode_run(const DATATYPE* X, size_t n, unsigned char* out){
+  unsigned char* p = out;
+  Key_bits prev;
+
+  if (n == 0)
+    return 0;
+  prev = to_bits(X[0]);
+  memcpy(p, &prev, sizeof(prev));
+  p += sizeof(prev);
+  for (size_t i = 1; i < n; i++) {
+    Key_bits cur = to_bits(X[i]);
+    Key_bits d = cur - prev; // wraps for -0.0 after 0.0: still decoded exactly
+    prev = cur;
+    while (d >= 0x80) {
+      *p++ = (unsigned char)(d | 0x80);
+      d >>= 7;
+    }
+    *p++ = (unsigned char) d;
+  }
+  return (size_t)(p - out);
+}
+
+size_t Decode_run(const unsigned char* in, size_t n, DATATYPE* X){
+  const unsigned char* p = in;
+  Key_bits cur;
+
+  if (n == 0)
+    return 0;
+  memcpy(&cur, p, sizeof(cur));
+  p += sizeof(cur);
+  X[0] = from_bits(cur);
+  for (size_t i = 1; i < n; i++) {
+    Key_bits d = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+      d |= (Key_bits)(*p++ & 0x7F) << shift;
+      shift += 7;
+    }
+    d |= (Key_bits)(*p++) << shift;
+    cur += d;
+    X[i] = from_bits(cur);
+  }
+  return (size_t)(p - in);
+}
+
+// chunks whose worst case encoding fits an int count of bytes
+static size_t clamp_chunk(size_t chunk){
+  size_t max_chunk = (INT_MAX - sizeof(DATATYPE)) / VARINT_MAX;
+  if (chunk == 0 || chunk > max_chunk)
+    chunk = (PIPELINE_CHUNK < max_chunk) ? PIPELINE_CHUNK : max_chunk;
+  return chunk;
+}
+
+void Send_compressed(const DATATYPE* A, size_t n, size_t chunk, int partner, MPI_Comm comm, Compress_stats* stats){
+  size_t n_chunks, depth, slot_bytes;
+  unsigned char* ring;
+  MPI_Request reqs[PIPELINE_DEPTH];
+
+  chunk = clamp_chunk(chunk);
+  n_chunks = (n + chunk - 1) / chunk;
+  depth = (n_chunks < PIPELINE_DEPTH) ? n_chunks : PIPELINE_DEPTH;
+  slot_bytes = ENCODED_MAX(chunk);
+  ring = malloc((depth > 0 ? depth : 1) * slot_bytes);
+
+  for (size_t c = 0; c < n_chunks; c++) {
+    size_t slot = c % depth;
+    size_t len = (c == n_chunks - 1) ? n - c * chunk : chunk;
+
+    if (c >= depth) // the buffer of the chunk c - depth is free again
+      MPI_Wait(&reqs[slot], MPI_STATUS_IGNORE);
+    TRACE_BEGIN(t_encode)
+    size_t bytes = Encode_run(A + c * chunk, len, ring + slot * slot_bytes);
+    TRACE_END(t_encode, "encode", -1, bytes);
+    MPI_Isend(ring + slot * slot_bytes, (int) bytes, MPI_BYTE, partner, 0, comm, &reqs[slot]);
+    stats->raw_bytes += len * sizeof(DATATYPE);
+    stats->sent_bytes += bytes;
+  }
+  MPI_Waitall((int) depth, reqs, MPI_STATUSES_IGNORE);
+  free(ring);
+}
+
+// number of keys of A[0..na) not greater than x (they precede x in the merge)
+static size_t not_greater(const DATATYPE* A, size_t na, DATATYPE x){
+  size_t lo = 0, hi = na;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (x < A[mid])
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+void Merge_compressed_stream(DATATYPE* A, size_t na, DATATYPE* C, size_t nb, size_t chunk, int partner, MPI_Comm comm){
+  size_t n_chunks, depth, slot_bytes, ai = 0, ci = 0, c;
+  unsigned char* ring;
+  DATATYPE* B;
+  MPI_Request reqs[PIPELINE_DEPTH];
+
+  chunk = clamp_chunk(chunk);
+  n_chunks = (nb + chunk - 1) / chunk;
+  depth = (n_chunks < PIPELINE_DEPTH) ? n_chunks : PIPELINE_DEPTH;
+  slot_bytes = ENCODED_MAX(chunk);
+  ring = malloc((depth > 0 ? depth : 1) * slot_bytes);
+  B = malloc((n_chunks > 0 ? chunk : 1) * sizeof(DATATYPE));
+
+  for (c = 0; c < depth; c++) // the length of a message is only known on arrival: post the worst case
+    MPI_Irecv(ring + c * slot_bytes, (int) slot_bytes, MPI_BYTE, partner, 0, comm, &reqs[c]);
+
+  for (c = 0; c < n_chunks; c++) {
+    size_t slot = c % depth;
+    size_t blen = (c == n_chunks - 1) ? nb - c * chunk : chunk;
+
+    TRACE_BEGIN(t_wait)
+    MPI_Wait(&reqs[slot], MPI_STATUS_IGNORE);
+    TRACE_END(t_wait, "wait", -1, blen * sizeof(DATATYPE));
+    TRACE_BEGIN(t_decode)
+    Decode_run(ring + slot * slot_bytes, blen, B);
+    TRACE_END(t_decode, "decode", -1, blen * sizeof(DATATYPE));
+    if (c + depth < n_chunks) // reuse the buffer for a following chunk
+      MPI_Irecv(ring + slot * slot_bytes, (int) slot_bytes, MPI_BYTE, partner, 0, comm, &reqs[slot]);
+
+    // the keys of A up to the last key of the chunk come before the rest of both lists
+    size_t take = not_greater(A + ai, na - ai, B[blen - 1]);
+    merge_simd(A + ai, take, B, blen, C + ci);
+    ai += take;
+    ci += take + blen;
+  }
+  memcpy(C + ci, A + ai, (na - ai) * sizeof(DATATYPE)); // finish up A
+  free(B);
+  free(ring);
+}
+
+void Merge_sort_compressed(DATATYPE** local_array, size_t size, int rank, int n_rank, size_t chunk, MPI_Comm comm, Compress_stats* stats) {
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+  size_t n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t cap = Merge_buffer_size(size, rank, n_rank);
+  DATATYPE *A = *local_array, *C = NULL, *tmp;
+
+  stats->raw_bytes = 0;
+  stats->sent_bytes = 0;
+  if (tree.n_children > 0) // leaves only send: no second buffer
+    C = malloc(cap * sizeof(DATATYPE));
+
+  for (int k = 0; k < tree.n_children; k++) { // process receive from its children while merging
+    size_t nb = Slice_offset(size, tree.child_end[k], n_rank) - Slice_offset(size, tree.child[k], n_rank);
+    TRACE_BEGIN(t_stream)
+    Merge_compressed_stream(A, n, C, nb, chunk, tree.child[k], comm);
+    TRACE_END(t_stream, "recv_merge", k, nb * sizeof(DATATYPE));
+    tmp = A; A = C; C = tmp;
+    n += nb;
+  }
+  if (tree.parent >= 0) { // process send to its parent
+    TRACE_BEGIN(t_send)
+    Send_compressed(A, n, chunk, tree.parent, comm, stats);
+    TRACE_END(t_send, "send", tree.n_children, stats->sent_bytes);
+  }
+
+  *local_array = A;
+  free(C);
+}
@@ -0,0 +1,371 @@
+/**
+ * @file externalMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Out-of-core parallel sort with scratch file runs and buffered k-way merge
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/externalMPI.h"
+#include "../include/samplesortMPI.h"
+#include "../include/utils.h"
+#include <unistd.h> // for unlink()
+
+/**
+ * @brief Destination of a merge: a scratch file or
+ * an MPI file written at an explicit offset.
+ */
+typedef struct {
+  FILE* fp;          // scratch file, NULL when writing to fh
+  MPI_File fh;
+  MPI_Offset offset; // next write position in fh (bytes)
+} Sink;
+
+/**
+ * @brief Buffered reader of a sorted run stored in a scratch file
+ */
+typedef struct {
+  FILE* fp;
+  DATATYPE* buf;
+  size_t len, pos;
+} Run_reader;
+
+static void sink_write(Sink* out, const DATATYPE* buf, size_t n){
+  if (n == 0)
+    return;
+  if (out->fp != NULL){
+    if (fwrite(buf, sizeof(DATATYPE), n, out->fp) != n){
+      fprintf(stderr,"can't write scratch file");
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+  }else{
+    int count;
+    MPI_Datatype type = Large_type(n, MPITYPE, &count);
+    MPI_File_write_at(out->fh, out->offset, buf, count, type, MPI_STATUS_IGNORE);
+    Free_large_type(&type, MPITYPE);
+    out->offset += (MPI_Offset) n * sizeof(DATATYPE);
+  }
+}
+
+/**
+ * @brief Create an anonymous scratch file in dir
+ * (it is removed as soon as it is closed).
+ */
+static FILE* scratch_file(const char* dir){
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/mergesort_run_XXXXXX", dir);
+  int fd = mkstemp(path);
+  if (fd < 0){
+    fprintf(stderr,"can't create scratch file in %s", dir);
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+  unlink(path);
+  return fdopen(fd, "w+b");
+}
+
+/**
+ * @brief Sort a run and spill it to a new scratch file, rewound for reading
+ */
+static FILE* spill_run(DATATYPE* run, size_t n, const char* dir){
+  FILE* fp = scratch_file(dir);
+  Sink s = {fp, MPI_FILE_NULL, 0};
+
+  local_sort(run, n);
+  sink_write(&s, run, n);
+  rewind(fp);
+  return fp;
+}
+
+static int reader_fill(Run_reader* r, size_t cap){
+  r->len = fread(r->buf, sizeof(DATATYPE), cap, r->fp);
+  r->pos = 0;
+  return r->len > 0;
+}
+
+static void reader_sift_down(int* heap, int n, int i, const Run_reader* r){
+  for (;;) {
+    int l = 2*i + 1, m = i;
+    if (l < n && r[heap[l]].buf[r[heap[l]].pos] < r[heap[m]].buf[r[heap[m]].pos]) m = l;
+    if (l + 1 < n && r[heap[l+1]].buf[r[heap[l+1]].pos] < r[heap[m]].buf[r[heap[m]].pos]) m = l + 1;
+    if (m == i) return;
+    int t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+    i = m;
+  }
+}
+
+/**
+ * @brief Buffered k-way merge of k sorted scratch files into out.
+ * The memory mem of mem_elems elements is split among
+ * the k input buffers and the output buffer.
+ */
+static void merge_runs(FILE** runs, int k, DATATYPE* mem, size_t mem_elems, Sink* out){
+  size_t b = mem_elems / (k + 1), o = 0;
+  DATATYPE* obuf = mem + (size_t) k * b;
+  Run_reader* r = malloc(k * sizeof(Run_reader));
+  int* heap = malloc(k * sizeof(int));
+  int i, n = 0;
+
+  for (i = 0; i < k; i++){
+    r[i].fp = runs[i];
+    r[i].buf = mem + (size_t) i * b;
+    if (reader_fill(&r[i], b))
+      heap[n++] = i;
+  }
+  for (i = n/2 - 1; i >= 0; i--)
+    reader_sift_down(heap, n, i, r);
+
+  while (n > 0){
+    Run_reader* top = &r[heap[0]];
+    obuf[o++] = top->buf[top->pos++];
+    if (o == b){
+      sink_write(out, obuf, o);
+      o = 0;
+    }
+    if (top->pos == top->len && !reader_fill(top, b))
+      heap[0] = heap[--n]; // run exhausted
+    reader_sift_down(heap, n, 0, r);
+  }
+  sink_write(out, obuf, o);
+
+  free(heap);
+  free(r);
+}
+
+/**
+ * @brief Number of splitters lower than (key, index), i.e. the
+ * process owning the element (see Sample_sort for the bucket bounds)
+ */
+static int bucket_of(const Splitter* splitters, int n, DATATYPE key, size_t index){
+  int lo = 0, hi = n;
+  while (lo < hi){
+    int mid = (lo + hi) / 2;
+    if (splitters[mid].key < key || (!(key < splitters[mid].key) && splitters[mid].index < index))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+void External_sort(char* filename, size_t size, const char* out_filename, size_t budget, const char* scratch_dir,
+                   int rank, int n_rank, MPI_Comm comm, double* run_time, double* merge_time) {
+  MPI_File fh;
+  DATATYPE *chunk_buf, *send_buf, *run;
+  Splitter *splitters, *samples;
+  size_t *send_counts, *send_displs, *recv_counts, *recv_displs, *fill, *take, *grant;
+  size_t budget_elems = budget / sizeof(DATATYPE);
+  // chunk_buf and send_buf take budget/4, the run and the scratch of its sort 3/4
+  size_t chunk = budget_elems / 8, run_cap = 3 * budget_elems / 8, run_len = 0;
+  size_t first = Slice_offset(size, rank, n_rank);
+  size_t slice = Slice_offset(size, rank + 1, n_rank) - first;
+  size_t max_slice, n_rounds, round, done = 0, received = 0, preceding = 0, total = 0;
+  FILE** runs = NULL;
+  int i, k = 0, max_k = 0;
+  double start, end, sum;
+
+  if (chunk == 0){ // the same on every process: an empty slice instead only takes part in the exchanges
+    if (rank == 0)
+      fprintf(stderr,"memory budget too small for the key size\n");
+    MPI_Abort(comm, EXIT_FAILURE);
+  }
+
+  //------------------------------ RUN FORMATION ------------------------------
+  START_T(start)
+
+  MPI_File_open(comm, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+
+  // splitters from samples evenly spaced in the file slice
+  size_t n_samples = (size_t) EXT_SAMPLES_PER_RANK * n_rank;
+  if (n_samples > slice)
+    n_samples = slice;
+  samples = malloc(n_samples * sizeof(Splitter));
+  splitters = malloc(n_rank * sizeof(Splitter));
+  for (size_t s = 0; s < n_samples; s++){ // the file position breaks the ties between equal keys
+    samples[s].index = first + s * slice / n_samples;
+    MPI_File_read_at(fh, (MPI_Offset) samples[s].index * sizeof(DATATYPE),
+                     &samples[s].key, 1, MPITYPE, MPI_STATUS_IGNORE);
+  }
+  qsort(samples, n_samples, sizeof(Splitter), Splitter_compare);
+  Select_splitters(samples, n_samples, n_rank, splitters, comm);
+  free(samples);
+
+  chunk_buf = malloc(chunk * sizeof(DATATYPE));
+  send_buf = malloc(chunk * sizeof(DATATYPE));
+  run = malloc(run_cap * sizeof(DATATYPE));
+  send_counts = malloc(7 * n_rank * sizeof(size_t));
+  send_displs = send_counts + n_rank;
+  recv_counts = send_counts + 2 * n_rank;
+  recv_displs = send_counts + 3 * n_rank;
+  fill = send_counts + 4 * n_rank;
+  take = send_counts + 5 * n_rank;
+  grant = send_counts + 6 * n_rank;
+
+  // every process takes part in the same number of exchanges
+  MPI_Allreduce(&slice, &max_slice, 1, MPI_SIZE_T, MPI_MAX, comm);
+  n_rounds = (max_slice + chunk - 1) / chunk;
+
+  for (round = 0; round < n_rounds; round++){
+    size_t n = (slice - done < chunk) ? slice - done : chunk;
+    size_t at = first + done; // file position of the chunk
+    int count;
+    MPI_Datatype type = Large_type(n, MPITYPE, &count);
+
+    MPI_File_read_at_all(fh, (MPI_Offset) at * sizeof(DATATYPE), chunk_buf, count, type, MPI_STATUS_IGNORE);
+    Free_large_type(&type, MPITYPE);
+    done += n;
+
+    // group the chunk by destination process
+    memset(send_counts, 0, n_rank * sizeof(size_t));
+    for (size_t j = 0; j < n; j++)
+      send_counts[bucket_of(splitters, n_rank - 1, chunk_buf[j], at + j)]++;
+    for (i = 0; i < n_rank; i++)
+      fill[i] = send_displs[i] = (i == 0) ? 0 : send_displs[i-1] + send_counts[i-1];
+    for (size_t j = 0; j < n; j++)
+      send_buf[fill[bucket_of(splitters, n_rank - 1, chunk_buf[j], at + j)]++] = chunk_buf[j];
+
+    MPI_Alltoall(send_counts, 1, MPI_SIZE_T, recv_counts, 1, MPI_SIZE_T, comm);
+    for (i = 0; i < n_rank; i++)
+      fill[i] = send_displs[i]; // next element to send to i
+
+    // the chunks of a round may bring a process more than its run buffer (skewed keys):
+    // they are received in exchanges of at most the free room of the buffer
+    for (;;){
+      size_t pending = 0, state[2], all[2];
+      for (i = 0; i < n_rank; i++)
+        pending += recv_counts[i];
+      if (pending > run_cap - run_len && run_len > 0){ // run buffer full: spill it
+        if (k == max_k){
+          max_k = (max_k == 0) ? 16 : 2 * max_k;
+          runs = realloc(runs, max_k * sizeof(FILE*));
+        }
+        runs[k++] = spill_run(run, run_len, scratch_dir);
+        run_len = 0;
+      }
+      state[0] = pending;
+      state[1] = (pending > run_cap - run_len);
+      MPI_Allreduce(state, all, 2, MPI_SIZE_T, MPI_MAX, comm);
+      if (all[0] == 0)
+        break;
+
+      // take from each sender what fits, then tell the senders what to send
+      size_t room = run_cap - run_len, incoming = 0;
+      for (i = 0; i < n_rank; i++){
+        take[i] = (recv_counts[i] < room - incoming) ? recv_counts[i] : room - incoming;
+        recv_displs[i] = incoming;
+        incoming += take[i];
+      }
+      if (all[1]) // somewhere it does not fit
+        MPI_Alltoall(take, 1, MPI_SIZE_T, grant, 1, MPI_SIZE_T, comm);
+      else
+        memcpy(grant, send_counts, n_rank * sizeof(size_t));
+
+      Alltoallv_large(send_buf, grant, fill,
+                      run + run_len, take, recv_displs, MPITYPE, comm);
+      for (i = 0; i < n_rank; i++){
+        send_counts[i] -= grant[i];
+        fill[i] += grant[i];
+        recv_counts[i] -= take[i];
+      }
+      run_len += incoming;
+      received += incoming;
+    }
+  }
+  MPI_File_close(&fh);
+  free(chunk_buf);
+  free(send_buf);
+  free(send_counts);
+  free(splitters);
+
+  // the last run stays in memory if it is the only one
+  if (k > 0 && run_len > 0){
+    if (k == max_k)
+      runs = realloc(runs, ++max_k * sizeof(FILE*));
+    runs[k++] = spill_run(run, run_len, scratch_dir);
+    run_len = 0;
+  }else if (k == 0){
+    local_sort(run, run_len);
+  }
+
+  END_T(end,start,comm,sum,"run_formation",slice * sizeof(DATATYPE))
+  *run_time = sum / n_rank;
+
+  //---------------------------------- MERGE ----------------------------------
+  START_T(start)
+
+  MPI_Exscan(&received, &preceding, 1, MPI_SIZE_T, MPI_SUM, comm);
+  if (rank == 0)
+    preceding = 0; // MPI_Exscan leaves it undefined on rank 0
+  MPI_Allreduce(&received, &total, 1, MPI_SIZE_T, MPI_SUM, comm);
+
+  MPI_File_open(comm, out_filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+  MPI_File_set_size(fh, (MPI_Offset) total * sizeof(DATATYPE)); // truncate stale content
+  Sink out = {NULL, fh, (MPI_Offset) preceding * sizeof(DATATYPE)};
+
+  if (k == 0){ // everything fit in memory
+    sink_write(&out, run, run_len);
+    free(run);
+  }else{
+    DATATYPE* mem;
+    int max_fanin;
+
+    free(run);
+    mem = malloc(budget_elems * sizeof(DATATYPE));
+    max_fanin = (int)(budget_elems / EXT_MIN_RUN_BUFFER) - 1;
+    if (max_fanin < 2)
+      max_fanin = 2;
+
+    // intermediate passes while the runs are too many for a single merge
+    while (k > max_fanin){
+      int new_k = 0;
+      for (i = 0; i < k; i += max_fanin){
+        int m = (k - i < max_fanin) ? k - i : max_fanin;
+        Sink s = {scratch_file(scratch_dir), MPI_FILE_NULL, 0};
+        merge_runs(runs + i, m, mem, budget_elems, &s);
+        for (int j = i; j < i + m; j++)
+          fclose(runs[j]);
+        rewind(s.fp);
+        runs[new_k++] = s.fp;
+      }
+      k = new_k;
+    }
+    merge_runs(runs, k, mem, budget_elems, &out);
+
+    for (i = 0; i < k; i++)
+      fclose(runs[i]);
+    free(mem);
+  }
+  free(runs);
+  MPI_File_close(&fh);
+
+  END_T(end,start,comm,sum,"run_merge",received * sizeof(DATATYPE))
+  *merge_time = sum / n_rank;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file generateMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Parallel generation of input files with MPI-IO collective writes
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/generateMPI.h"
+#include <math.h>
+#include <string.h>
+
+static const char* DIST_NAMES[] = { "uniform", "sorted", "reverse", "nearly", "organ", "zipf", "few", "equal" };
+
+// parameters of a distribution
+typedef struct {
+  int dist;
+  uint64_t seed;
+  size_t size;
+  size_t unique;   // distinct keys of zipf and few
+  double zipf_s;   // exponent of zipf
+  double disorder; // fraction of keys out of place of nearly
+} Gen_config;
+
+// splitmix64 finalizer: a well mixed 64 bit value of x
+static inline uint64_t mix64(uint64_t x){
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// random 64 bit value of element i in the given stream (stream 1 of zipf and few: value of the key i): depends only on seed and i (counter based)
+static inline uint64_t random_at(uint64_t seed, size_t i, int stream){
+  return mix64(seed + (2 * (uint64_t) i + stream + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+// uniform double in [0, 1) from the 53 high bits of r
+static inline double unit(uint64_t r){
+  return (r >> 11) * 0x1.0p-53;
+}
+
+// key of the ordinal q: the map is monotone, so ordered ordinals give ordered keys
+static inline DATATYPE key_at(uint64_t q){
+#if DATATYPE_ID == DT_INT32
+  return (int32_t) (uint32_t) ((q >> 32) ^ 0x80000000u);
+#elif DATATYPE_ID == DT_INT64
+  return (int64_t) (q ^ 0x8000000000000000ULL);
+#elif DATATYPE_ID == DT_UINT64
+  return q;
+#else
+  return (DATATYPE) (2 * unit(q) - 1); // [-1, 1)
+#endif
+}
+
+// rank in [0, n) with probability proportional to 1 / (rank + 1)^s (inverse of the continuous CDF)
+static inline uint64_t zipf_rank(double u, size_t n, double s){
+  double x = (fabs(s - 1) < 1e-9) ? pow((double) n, u)
+                                   : pow((pow((double) n, 1 - s) - 1) * u + 1, 1 / (1 - s));
+  uint64_t k = (uint64_t) x;
+  return (k >= 1 && k <= n) ? k - 1 : n - 1;
+}
+
+/**
+ * @brief Key of element i of the file with the distribution of c.
+ */
+static DATATYPE key_of_element(const Gen_config* c, size_t i){
+  uint64_t step = UINT64_MAX / (c->size > 0 ? c->size : 1); // ordinal distance of consecutive sorted keys
+
+  switch (c->dist) {
+  case GEN_SORTED:
+    return key_at(i * step);
+  case GEN_REVERSE:
+    return key_at((c->size - 1 - i) * step);
+  case GEN_NEARLY: // sorted, but a fraction disorder of the keys is random
+    if (unit(random_at(c->seed, i, 1)) < c->disorder)
+      return key_at(random_at(c->seed, i, 0));
+    return key_at(i * step);
+  case GEN_ORGAN_PIPE: // ascending on the first half, descending on the second
+    return key_at(((i < c->size / 2) ? 2 * i : 2 * (c->size - 1 - i) + 1) * step);
+  case GEN_ZIPF: // the popular keys are scattered over the key space
+    return key_at(random_at(c->seed, zipf_rank(unit(random_at(c->seed, i, 0)), c->unique, c->zipf_s), 1));
+  case GEN_FEW:
+    return key_at(random_at(c->seed, random_at(c->seed, i, 0) % c->unique, 1));
+  case GEN_EQUAL:
+    return key_at(random_at(c->seed, 0, 1));
+  default: // GEN_UNIFORM
+    return key_at(random_at(c->seed, i, 0));
+  }
+}
+
+// value of a non negative floating point option (def when not given)
+static double double_opt(int argc, char* argv[], const char* name, double def){
+  const char* opt = get_opt(argc, argv, name);
+  char* end;
+
+  if (opt == NULL)
+    return def;
+  double v = strtod(opt, &end);
+  if (*end != '\0' || !(v >= 0)) {
+    fprintf(stderr,"not valid --%s %s\n", name, opt);
+    exit(EXIT_FAILURE);
+  }
+  return v;
+}
+
+int gen_main(int argc, char* argv[]){
+  int rank, n_rank;
+  MPI_Comm comm;
+  MPI_File fh;
+  MPI_Status status;
+  Gen_config c;
+  double start, end, sum;
+
+  MPI_Init(&argc, &argv);
+  comm = MPI_COMM_WORLD;
+  MPI_Comm_size(comm, &n_rank);
+  MPI_Comm_rank(comm, &rank);
+
+  if (count_positional(argc, argv) < 3){
+    if (rank == 0)
+      fprintf(stderr,"Usage:\n\t%s [output_fileName] [size] [--dist=uniform,sorted,reverse,nearly,organ,zipf,few,equal (default = uniform)]"
+                     " [--seed=seed (default = 0)] [--unique=distinct keys of zipf and few (default = GEN_ZIPF_KEYS, GEN_FEW_UNIQUE)]"
+                     " [--zipf=exponent (default = GEN_ZIPF_S)] [--disorder=fraction of nearly (default = GEN_DISORDER)]"
+                     " [--dtype=key type int32,int64,uint64,float,double (default = int32)]\n",argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  char* filename = argv[1];
+  c.size = check_size_input(argv[2], sizeof(DATATYPE));
+  const char* opt = get_opt(argc, argv, "dist");
+  c.dist = GEN_UNIFORM;
+  if (opt != NULL) {
+    c.dist = -1;
+    for (int d = 0; d < (int) (sizeof(DIST_NAMES) / sizeof(DIST_NAMES[0])); d++)
+      if (strcmp(opt, DIST_NAMES[d]) == 0)
+        c.dist = d;
+    if (c.dist < 0) {
+      if (rank == 0)
+        fprintf(stderr,"unknown --dist %s\n", opt);
+      MPI_Abort(comm, EXIT_FAILURE);
+    }
+  }
+  opt = get_opt(argc, argv, "seed");
+  c.seed = (opt != NULL) ? check_size_input(opt, 1) : 0;
+  opt = get_opt(argc, argv, "unique");
+  c.unique = (opt != NULL) ? check_size_input(opt, 1) : ((c.dist == GEN_ZIPF) ? GEN_ZIPF_KEYS : GEN_FEW_UNIQUE);
+  if (c.unique == 0)
+    c.unique = 1;
+  c.zipf_s = double_opt(argc, argv, "zipf", GEN_ZIPF_S);
+  c.disorder = double_opt(argc, argv, "disorder", GEN_DISORDER);
+
+  size_t first = Slice_offset(c.size, rank, n_rank);
+  size_t local_size = Slice_offset(c.size, rank + 1, n_rank) - first;
+  // the writes are collective: every process does as many as the largest slice needs
+  size_t max_size = c.size / n_rank + (c.size % n_rank != 0);
+  size_t n_blocks = (max_size + GEN_BLOCK - 1) / GEN_BLOCK;
+  DATATYPE* block = malloc(GEN_BLOCK * sizeof(DATATYPE));
+
+  START_T(start)
+  MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+  MPI_File_set_size(fh, (MPI_Offset) (c.size * sizeof(DATATYPE))); // truncate stale content
+
+  for (size_t b = 0; b < n_blocks; b++) {
+    size_t lo = b * GEN_BLOCK;
+    size_t n = (lo < local_size) ? ((local_size - lo < GEN_BLOCK) ? local_size - lo : GEN_BLOCK) : 0;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++)
+      block[i] = key_of_element(&c, first + lo + i);
+
+    MPI_File_write_at_all(fh, (MPI_Offset) ((first + lo) * sizeof(DATATYPE)), block, (int) n, MPITYPE, &status);
+  }
+  MPI_File_close(&fh);
+  end = MPI_Wtime() - start;
+
+  MPI_Reduce(&end, &sum, 1, MPI_DOUBLE, MPI_MAX, 0, comm); // the file is done when the slowest process is
+  if (rank == 0)
+    printf("%s;%s;%zu;%d;%llu;%.6f;%.3f\n", DATATYPE_NAME, DIST_NAMES[c.dist], c.size, n_rank,
+           (unsigned long long) c.seed, sum, (double) c.size * sizeof(DATATYPE) / sum / 1e9);
+
+  free(block);
+  MPI_Finalize();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file hierMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Node-aware hierarchical merge through MPI shared memory windows
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/hierMPI.h"
+#include "../include/utils.h"
+
+// make the stores of the node ranks in the window visible to each other
+static void node_sync(Hier_merge* h){
+  MPI_Win_sync(h->win);
+  MPI_Barrier(h->node_comm);
+  MPI_Win_sync(h->win);
+}
+
+DATATYPE* Hier_setup(Hier_merge* h, size_t size, int node_size, int rank, int n_rank, MPI_Comm comm) {
+  size_t local_n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t node_total = 0;
+  MPI_Comm shared_comm;
+  MPI_Aint win_size;
+  int disp_unit;
+
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shared_comm);
+  if (node_size > 0) { // simulated nodes: consecutive ranks of the shared communicator
+    int shared_rank;
+    MPI_Comm_rank(shared_comm, &shared_rank);
+    MPI_Comm_split(shared_comm, shared_rank / node_size, rank, &h->node_comm);
+    MPI_Comm_free(&shared_comm);
+  } else
+    h->node_comm = shared_comm;
+  MPI_Comm_rank(h->node_comm, &h->node_rank);
+  MPI_Comm_size(h->node_comm, &h->node_n);
+  // the lowest rank of a node leads it, so rank 0 is leader 0
+  MPI_Comm_split(comm, (h->node_rank == 0) ? 0 : MPI_UNDEFINED, rank, &h->leader_comm);
+
+  // slices of the node ranks, one after the other in the window
+  h->node_offsets = malloc((h->node_n + 1) * sizeof(size_t));
+  h->node_offsets[0] = 0;
+  MPI_Allgather(&local_n, 1, MPI_SIZE_T, h->node_offsets + 1, 1, MPI_SIZE_T, h->node_comm);
+  for (int i = 0; i < h->node_n; i++)
+    h->node_offsets[i + 1] += h->node_offsets[i];
+  node_total = h->node_offsets[h->node_n];
+
+  // the leader holds the lists of its subtree of the leaders' tree merge
+  h->cap = node_total;
+  if (h->leader_comm != MPI_COMM_NULL) {
+    int l_rank, l_n;
+    MPI_Comm_rank(h->leader_comm, &l_rank);
+    MPI_Comm_size(h->leader_comm, &l_n);
+
+    size_t* totals = malloc((l_n + 1) * sizeof(size_t));
+    totals[0] = 0;
+    MPI_Allgather(&node_total, 1, MPI_SIZE_T, totals + 1, 1, MPI_SIZE_T, h->leader_comm);
+    for (int i = 0; i < l_n; i++)
+      totals[i + 1] += totals[i];
+    Merge_tree tree = Merge_schedule(l_rank, l_n);
+    h->cap = totals[tree.end] - totals[l_rank];
+    free(totals);
+  }
+  MPI_Bcast(&h->cap, 1, MPI_SIZE_T, 0, h->node_comm);
+
+  win_size = (h->node_rank == 0) ? (MPI_Aint)(2 * (h->cap > 0 ? h->cap : 1) * sizeof(DATATYPE)) : 0;
+  MPI_Win_allocate_shared(win_size, sizeof(DATATYPE), MPI_INFO_NULL, h->node_comm, &h->buf[0], &h->win);
+  MPI_Win_shared_query(h->win, 0, &win_size, &disp_unit, &h->buf[0]);
+  h->buf[1] = h->buf[0] + (h->cap > 0 ? h->cap : 1);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, h->win); // passive target epoch: load/store plus node_sync
+
+  return h->buf[0] + h->node_offsets[h->node_rank];
+}
+
+DATATYPE* Hier_merge_sort(Hier_merge* h) {
+  const size_t* off = h->node_offsets;
+  int s = 0; // the runs are in buf[s]
+
+  node_sync(h); // the sorted slices of all the node ranks are in the window
+
+  for (int w = 1, level = 0; w < h->node_n; w *= 2, level++) {
+    // ranks [lo, hi) merge runs [lo, mid) and [mid, hi) together
+    int lo = h->node_rank / (2 * w) * (2 * w);
+    int mid = (lo + w < h->node_n) ? lo + w : h->node_n;
+    int hi = (lo + 2 * w < h->node_n) ? lo + 2 * w : h->node_n;
+    DATATYPE* A = h->buf[s] + off[lo];
+    DATATYPE* B = h->buf[s] + off[mid];
+    size_t na = off[mid] - off[lo], nb = off[hi] - off[mid];
+    size_t t = na + nb, j = h->node_rank - lo, workers = hi - lo;
+
+    // output positions [d0, d1) of the merge, taken by merge path
+    size_t d0 = t * j / workers, d1 = t * (j + 1) / workers;
+    TRACE_BEGIN(t_merge)
+    size_t i0 = co_rank(d0, A, na, B, nb), i1 = co_rank(d1, A, na, B, nb);
+    merge_simd(A + i0, i1 - i0, B + (d0 - i0), (d1 - i1) - (d0 - i0), h->buf[1 - s] + off[lo] + d0);
+    TRACE_END(t_merge, "node_merge", level, (d1 - d0) * sizeof(DATATYPE));
+
+    TRACE_BEGIN(t_sync)
+    node_sync(h);
+    TRACE_END(t_sync, "node_sync", level, 0);
+    s = 1 - s;
+  }
+
+  if (h->leader_comm == MPI_COMM_NULL)
+    return NULL;
+
+  // tree merge of the nodes, as Merge_sort with the node lists as slices
+  int l_rank, l_n;
+  MPI_Comm_rank(h->leader_comm, &l_rank);
+  MPI_Comm_size(h->leader_comm, &l_n);
+  size_t n = off[h->node_n];
+  size_t* totals = malloc((l_n + 1) * sizeof(size_t));
+  totals[0] = 0;
+  MPI_Allgather(&n, 1, MPI_SIZE_T, totals + 1, 1, MPI_SIZE_T, h->leader_comm);
+  for (int i = 0; i < l_n; i++)
+    totals[i + 1] += totals[i];
+
+  Merge_tree tree = Merge_schedule(l_rank, l_n);
+  DATATYPE *A = h->buf[s], *C = h->buf[1 - s], *tmp;
+
+  for (int k = 0; k < tree.n_children; k++) { // leader receive from its children
+    size_t nb = totals[tree.child_end[k]] - totals[tree.child[k]];
+    TRACE_BEGIN(t_recv)
+    Recv_large(A + n, nb, MPITYPE, tree.child[k], 0, h->leader_comm);
+    TRACE_END(t_recv, "recv", k, nb * sizeof(DATATYPE));
+    TRACE_BEGIN(t_merge)
+    Merge(A, n, A + n, nb, C);
+    TRACE_END(t_merge, "merge", k, (n + nb) * sizeof(DATATYPE));
+    tmp = A; A = C; C = tmp;
+    n += nb;
+  }
+  if (tree.parent >= 0) { // leader send to its parent
+    TRACE_BEGIN(t_send)
+    Send_large(A, n, MPITYPE, tree.parent, 0, h->leader_comm);
+    TRACE_END(t_send, "send", tree.n_children, n * sizeof(DATATYPE));
+  }
+
+  free(totals);
+  return A;
+}
+
+void Hier_free(Hier_merge* h) {
+  MPI_Win_unlock_all(h->win);
+  MPI_Win_free(&h->win);
+  if (h->leader_comm != MPI_COMM_NULL)
+    MPI_Comm_free(&h->leader_comm);
+  MPI_Comm_free(&h->node_comm);
+  free(h->node_offsets);
+}
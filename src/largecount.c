@@ -0,0 +1,150 @@
+/**
+ * @file largecount.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief MPI transfers with more than INT_MAX elements through derived datatypes
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/largecount.h"
+#include <stdlib.h>
+
+MPI_Datatype Contiguous_large(size_t count, MPI_Datatype base){
+  MPI_Datatype block, blocks, rest, type;
+  MPI_Aint lb, extent;
+
+  if (count <= LARGE_COUNT_LIMIT){
+    MPI_Type_contiguous((int) count, base, &type);
+    MPI_Type_commit(&type);
+    return type;
+  }
+
+  size_t n_blocks = count / LARGE_COUNT_LIMIT;
+  size_t n_rest = count % LARGE_COUNT_LIMIT;
+
+  MPI_Type_contiguous(LARGE_COUNT_LIMIT, base, &block);
+  MPI_Type_contiguous((int) n_blocks, block, &blocks);
+
+  if (n_rest == 0){
+    type = blocks;
+  }else{ // blocks followed by the remainder
+    MPI_Type_get_extent(base, &lb, &extent);
+    MPI_Type_contiguous((int) n_rest, base, &rest);
+
+    int lengths[2] = {1, 1};
+    MPI_Aint displs[2] = {0, (MPI_Aint)(n_blocks * LARGE_COUNT_LIMIT) * extent};
+    MPI_Datatype types[2] = {blocks, rest};
+    MPI_Type_create_struct(2, lengths, displs, types, &type);
+
+    MPI_Type_free(&rest);
+    MPI_Type_free(&blocks);
+  }
+  MPI_Type_free(&block);
+  MPI_Type_commit(&type);
+
+  return type;
+}
+
+MPI_Datatype Large_type(size_t count, MPI_Datatype base, int* n){
+  if (count <= LARGE_COUNT_LIMIT){
+    *n = (int) count;
+    return base;
+  }
+  *n = 1;
+  return Contiguous_large(count, base);
+}
+
+void Free_large_type(MPI_Datatype* type, MPI_Datatype base){
+  if (*type != base)
+    MPI_Type_free(type);
+}
+
+void Send_large(const void* buf, size_t count, MPI_Datatype base, int dest, int tag, MPI_Comm comm){
+  int n;
+  MPI_Datatype type = Large_type(count, base, &n);
+  MPI_Send(buf, n, type, dest, tag, comm);
+  Free_large_type(&type, base);
+}
+
+void Recv_large(void* buf, size_t count, MPI_Datatype base, int source, int tag, MPI_Comm comm){
+  int n;
+  MPI_Datatype type = Large_type(count, base, &n);
+  MPI_Recv(buf, n, type, source, tag, comm, MPI_STATUS_IGNORE);
+  Free_large_type(&type, base);
+}
+
+void Alltoallv_large(const void* sendbuf, const size_t* send_counts, const size_t* send_displs,
+                     void* recvbuf, const size_t* recv_counts, const size_t* recv_displs,
+                     MPI_Datatype base, MPI_Comm comm){
+  int n_rank, i, fits = 1, all_fit;
+  MPI_Aint lb, extent;
+
+  MPI_Comm_size(comm, &n_rank);
+  for (i = 0; i < n_rank; i++)
+    if (send_displs[i] + send_counts[i] > LARGE_COUNT_LIMIT || recv_displs[i] + recv_counts[i] > LARGE_COUNT_LIMIT)
+      fits = 0;
+  // every process must take the same path
+  MPI_Allreduce(&fits, &all_fit, 1, MPI_INT, MPI_LAND, comm);
+
+  if (all_fit){
+    int *sc = malloc(4 * n_rank * sizeof(int));
+    int *sd = sc + n_rank, *rc = sc + 2 * n_rank, *rd = sc + 3 * n_rank;
+    for (i = 0; i < n_rank; i++){
+      sc[i] = (int) send_counts[i]; sd[i] = (int) send_displs[i];
+      rc[i] = (int) recv_counts[i]; rd[i] = (int) recv_displs[i];
+    }
+    MPI_Alltoallv(sendbuf, sc, sd, base, recvbuf, rc, rd, base, comm);
+    free(sc);
+    return;
+  }
+
+  MPI_Type_get_extent(base, &lb, &extent);
+  MPI_Request* reqs = malloc(2 * n_rank * sizeof(MPI_Request));
+  MPI_Datatype* types = malloc(2 * n_rank * sizeof(MPI_Datatype));
+
+  for (i = 0; i < n_rank; i++){
+    int n;
+    types[i] = Large_type(recv_counts[i], base, &n);
+    MPI_Irecv((char*) recvbuf + recv_displs[i] * extent, n, types[i], i, 0, comm, &reqs[i]);
+  }
+  for (i = 0; i < n_rank; i++){
+    int n;
+    types[n_rank + i] = Large_type(send_counts[i], base, &n);
+    MPI_Isend((const char*) sendbuf + send_displs[i] * extent, n, types[n_rank + i], i, 0, comm, &reqs[n_rank + i]);
+  }
+  MPI_Waitall(2 * n_rank, reqs, MPI_STATUSES_IGNORE);
+
+  for (i = 0; i < 2 * n_rank; i++)
+    Free_large_type(&types[i], base);
+  free(types);
+  free(reqs);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file main.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Entry point: runs the sort (or benchmark) compiled for the key type selected by --dtype
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+#include "../include/args.h"
+
+/*
+ * ENTRY of the typed sources (sort_main of mergeMPI.c or mergesort_serial.c,
+ * bench_main of benchMPI.c or gen_main of generateMPI.c, whichever is linked),
+ * compiled once per key type (see datatype.h).
+ */
+#ifndef ENTRY
+#define ENTRY sort_main
+#endif
+#define ENTRY_CAT(entry, suffix) entry##_##suffix
+#define ENTRY_NAME(entry, suffix) ENTRY_CAT(entry, suffix)
+#define ENTRY_FOR(suffix) ENTRY_NAME(ENTRY, suffix)
+
+int ENTRY_FOR(i32)(int argc, char* argv[]);
+int ENTRY_FOR(i64)(int argc, char* argv[]);
+int ENTRY_FOR(u64)(int argc, char* argv[]);
+int ENTRY_FOR(f32)(int argc, char* argv[]);
+int ENTRY_FOR(f64)(int argc, char* argv[]);
+
+static const struct {
+  const char* name;
+  int (*entry)(int argc, char* argv[]);
+} key_types[] = {
+  { "int32",  ENTRY_FOR(i32) },
+  { "int64",  ENTRY_FOR(i64) },
+  { "uint64", ENTRY_FOR(u64) },
+  { "float",  ENTRY_FOR(f32) },
+  { "double", ENTRY_FOR(f64) },
+};
+
+int main(int argc, char* argv[]) {
+  const char* dtype = get_opt(argc, argv, "dtype");
+
+  if (dtype == NULL)
+    return ENTRY_FOR(i32)(argc, argv);
+
+  for (size_t i = 0; i < sizeof(key_types) / sizeof(key_types[0]); i++)
+    if (strcmp(dtype, key_types[i].name) == 0)
+      return key_types[i].entry(argc, argv);
+
+  fprintf(stderr,"unknown --dtype %s (int32, int64, uint64, float, double)\n", dtype);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file mapfile.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Memory mapped input: the processes sort straight from the page cache
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/mapfile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef MAP_POPULATE
+#define MAP_FLAGS (MAP_SHARED | MAP_POPULATE)
+#else
+#define MAP_FLAGS MAP_SHARED
+#endif
+
+int Map_file(const char* filename, size_t offset, size_t length, Mapped_file* map){
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  size_t aligned = offset - offset % page; // mmap wants a page aligned offset
+  struct stat st;
+
+  map->data = NULL;
+  map->base = NULL;
+  map->length = 0;
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+  if ((size_t) st.st_size < offset + length) { // the file is shorter than the range
+    close(fd);
+    errno = EINVAL;
+    return -1;
+  }
+  if (length == 0) { // nothing to map (an empty slice)
+    close(fd);
+    return 0;
+  }
+
+  void* base = mmap(NULL, length + (offset - aligned), PROT_READ, MAP_FLAGS, fd, (off_t) aligned);
+  close(fd); // the mapping keeps the file open
+  if (base == MAP_FAILED)
+    return -1;
+#ifndef MAP_POPULATE
+  madvise(base, length + (offset - aligned), MADV_WILLNEED);
+#endif
+  madvise(base, length + (offset - aligned), MADV_SEQUENTIAL);
+
+  map->base = base;
+  map->length = length + (offset - aligned);
+  map->data = (const char*) base + (offset - aligned);
+  return 0;
+}
+
+void Unmap_file(Mapped_file* map){
+  if (map->base != NULL)
+    munmap(map->base, map->length);
+  map->data = NULL;
+  map->base = NULL;
+  map->length = 0;
+}
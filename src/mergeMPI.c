@@ -36,69 +36,284 @@
  */
 
 #include "../include/mergeMPI.h"
+#include "../include/samplesortMPI.h"
+#include "../include/externalMPI.h"
+#include "../include/recordMPI.h"
+#include "../include/hierMPI.h"
+#include "../include/compressMPI.h"
+#include "../include/selectMPI.h"
+#include "../include/radixsort.h"
+#include "../include/pdqsort.h"
+#include "../include/runsort.h"
 #include "../include/utils.h"
 
-int SORT_TYPE = 0;
+static int SORT_TYPE = 0;
+static int N_THREADS = 1; // threads of the local sort of each process
+static int MERGE_TYPE = 0; // 0: tree merge on rank 0, 1: sample sort (result distributed), 2: pipelined tree merge on rank 0,
+                           // 3: hierarchical merge on rank 0 (shared memory in the nodes, see Hier_merge_sort),
+                           // 4: merge path tree merge (result distributed, see Merge_sort_path)
 
-int main(int argc, char * argv[]) {
+int sort_main(int argc, char * argv[]) {
 
   int rank, n_rank;
   DATATYPE *local_array;
-  int local_size;
+  size_t local_size;
   MPI_Comm comm;
 
-  double init_time, local_time_sort;
+  double init_time, local_time_sort, write_time = 0, hidden_time = 0;
 
-  MPI_Init(&argc, &argv);
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided); // only the main thread calls MPI
   comm = MPI_COMM_WORLD;
   MPI_Comm_size(comm, &n_rank);
   MPI_Comm_rank(comm, &rank);
 
-  if (argc < 5){
+  int n_pos = count_positional(argc, argv);
+  if (n_pos < 5){
     if(rank == 0)
-		  fprintf(stderr,"Usage:\n\t%s [input_fileName] [inputSize] [VERSION] [SORT TYPE 0,1] [testMode (default = 0)]\n",argv[0]);
+		  fprintf(stderr,"Usage:\n\t%s [input_fileName] [inputSize] [VERSION] [SORT TYPE 0,1,2,3] [testMode (default = 0)]"
+                     " [--threads=local sort threads (default = 1)] [--kernel=merge kernel scalar,sse4,avx2,avx512 (default = auto)] [--merge=MERGE TYPE 0,1,2,3,4 (default = 0)] [--chunk=pipeline chunk size (default = PIPELINE_CHUNK)] [--output=output_fileName]"
+                     " [--memory=budget in MB per process (out-of-core sort, needs --output)] [--scratch=scratch dir (default = /tmp)]"
+                     " [--node-size=ranks of a simulated node of --merge=3 (default = the shared memory nodes)]"
+                     " [--trace=prefix of the timeline files prefix.json (Chrome trace) and prefix.<rank>.csv]"
+                     " [--mmap (map the input and sort the slices straight from the page cache, instead of the VERSION read)]"
+                     " [--ingest=chunks of a slice read while the previous one is sorted (default = INGEST_CHUNKS)] [--ingest-chunk=elements of a chunk]"
+                     " [--compress (delta + varint encoded messages in the tree merge of --merge=0,2)]"
+                     " [--select=ranks,... (keys of these ranks, 0 is the smallest)] [--percentile=p,... (nearest rank percentiles)] [--top=k (the k largest keys)]"
+                     " [--dtype=key type int32,int64,uint64,float,double (default = int32)]"
+                     " [--record=record bytes (sort records with a key of type dtype)] [--key-offset=key offset in the record (default = 0)]"
+                     " [--record-sort=0 auto, 1 direct, 2 (key, index) (default = 0)]\n",argv[0]);
 		exit(EXIT_FAILURE);
   }
 
   char* filename = argv[1];
-  int size = check_int_input(argv[2]);
+  size_t size = check_size_input(argv[2], sizeof(DATATYPE));
   int VERSION = check_int_input(argv[3]);
   SORT_TYPE = check_int_input(argv[4]);
-  int testMode = (argc == 6) ? check_int_input(argv[5]) : 0;
+  int testMode = (n_pos == 6) ? check_int_input(argv[5]) : 0;
+  const char* opt = get_opt(argc, argv, "merge");
+  MERGE_TYPE = (opt != NULL) ? check_int_input(opt) : 0;
+  opt = get_opt(argc, argv, "threads");
+  N_THREADS = (opt != NULL) ? check_int_input(opt) : 1;
+  merge_kernel_select(get_opt(argc, argv, "kernel"));
+  if (testMode && rank == 0)
+    printf("merge kernel: %s\n", merge_kernel_name());
+  opt = get_opt(argc, argv, "chunk");
+  size_t chunk = (opt != NULL) ? check_size_input(opt, sizeof(DATATYPE)) : PIPELINE_CHUNK;
+  opt = get_opt(argc, argv, "node-size");
+  int node_size = (opt != NULL) ? check_int_input(opt) : 0;
+  Trace_init(get_opt(argc, argv, "trace"), comm);
+  const char* out_filename = get_opt(argc, argv, "output");
+  const char* memory = get_opt(argc, argv, "memory");
+  int use_mmap = (get_opt(argc, argv, "mmap") != NULL);
+  const char* ingest_chunks = get_opt(argc, argv, "ingest");
+  const char* ingest_chunk = get_opt(argc, argv, "ingest-chunk");
+  size_t n_ingest = (ingest_chunks != NULL) ? check_size_input(ingest_chunks, 1) : INGEST_CHUNKS;
+  size_t ingest_size = (ingest_chunk != NULL) ? check_size_input(ingest_chunk, sizeof(DATATYPE)) : 0;
+  if (n_ingest == 0 || (ingest_chunk != NULL && ingest_size == 0)){
+    if (rank == 0)
+      fprintf(stderr,"--ingest and --ingest-chunk require at least one element\n");
+    exit(EXIT_FAILURE);
+  }
+  int compress = (get_opt(argc, argv, "compress") != NULL) && (MERGE_TYPE == 0 || MERGE_TYPE == 2);
+  Compress_stats cstats = {0, 0};
+
+  if (memory != NULL){ // out-of-core sort: the input is never fully in memory
+    const char* scratch_dir = get_opt(argc, argv, "scratch");
+    double run_time, merge_time;
+
+    if (out_filename == NULL){
+      if (rank == 0)
+        fprintf(stderr,"--memory requires --output\n");
+      exit(EXIT_FAILURE);
+    }
+    External_sort(filename, size, out_filename, check_size_input(memory, 1 << 20) << 20,
+                  (scratch_dir != NULL) ? scratch_dir : "/tmp", rank, n_rank, comm, &run_time, &merge_time);
+
+    // OUTPUT
+    if (rank == 0)
+      printf("%zu;%d;%lf;%lf",size,n_rank,run_time,merge_time);
+
+    Trace_finish(comm);
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+  }
+
+  const char* record = get_opt(argc, argv, "record");
+
+  if (record != NULL){ // records: a key of type DATATYPE plus payload, inputSize counts records
+    size_t rec_size = check_size_input(record, 1);
+    opt = get_opt(argc, argv, "key-offset");
+    size_t key_offset = (opt != NULL) ? check_size_input(opt, 1) : 0;
+    opt = get_opt(argc, argv, "record-sort");
+    int strategy = (opt != NULL) ? check_int_input(opt) : RECORD_SORT_AUTO;
+    double merge_time;
+
+    if (rec_size > INT_MAX || key_offset + sizeof(DATATYPE) > rec_size){
+      if (rank == 0)
+        fprintf(stderr,"the key (offset %zu) does not fit a record of %zu bytes\n", key_offset, rec_size);
+      exit(EXIT_FAILURE);
+    }
+    Record_sort(filename, size, out_filename, rec_size, key_offset, strategy, VERSION, testMode,
+                rank, n_rank, comm, &init_time, &local_time_sort, &merge_time, &write_time);
+
+    // OUTPUT: the columns of the sort of the keys
+    if (rank == 0){
+      printf("%zu;%d;%lf;%lf;%lf",size,n_rank,init_time,local_time_sort,merge_time);
+      if (out_filename != NULL)
+        printf(";%lf",write_time);
+    }
+
+    Trace_finish(comm);
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+  }
+
+  const char* select_ranks = get_opt(argc, argv, "select");
+  const char* percentiles = get_opt(argc, argv, "percentile");
+  const char* top = get_opt(argc, argv, "top");
 
+  if (select_ranks != NULL || percentiles != NULL || top != NULL){ // queries: distributed selection, no sort
+    size_t *k, n_k = Query_ranks(select_ranks, percentiles, size, &k);
+    size_t k_top = (top != NULL) ? check_size_input(top, sizeof(DATATYPE)) : 0;
+    if (k_top > size)
+      k_top = size;
+    double select_time;
 
-  local_size = size / n_rank;
-  local_array = malloc(size * sizeof(DATATYPE)); // n_rank * local_size * sizeof(DATATYPE)
+    local_size = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+    local_array = malloc((local_size > 0 ? local_size : 1) * sizeof(DATATYPE));
+    DATATYPE* answers = malloc((n_k + k_top > 0 ? n_k + k_top : 1) * sizeof(DATATYPE));
 
-  init_time = init(local_array, local_size, n_rank, rank, filename, VERSION, comm);
+    init_time = init(local_array, size, n_rank, rank, filename, VERSION, comm);
+    select_time = Select_queries(local_array, local_size, size, k, n_k, k_top, answers, rank, n_rank, comm);
+
+    // OUTPUT: the keys of the ranks in order, then the k largest from the largest
+    if (rank == 0){
+      printf("%zu;%d;%lf;%lf",size,n_rank,init_time,select_time);
+      for (size_t q = 0; q < n_k; q++)
+        printf(";" DATATYPE_FMT, answers[q]);
+      for (size_t q = n_k + k_top; q-- > n_k;)
+        printf(";" DATATYPE_FMT, answers[q]);
+    }
+
+    free(answers);
+    free(local_array);
+    free(k);
+    Trace_finish(comm);
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+  }
+
+  // slices differ by at most one element (see Slice_offset)
+  local_size = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  Hier_merge hier;
+  if (MERGE_TYPE == 3) // the slice is in the shared window of the node
+    local_array = Hier_setup(&hier, size, node_size, rank, n_rank, comm);
+  else {
+    // each process allocates only what it will hold at the end of the merge
+    // (sample sort reallocates it)
+    size_t capacity = (MERGE_TYPE == 1 || MERGE_TYPE == 4) ? local_size : Merge_buffer_size(size, rank, n_rank);
+    local_array = malloc((capacity > 0 ? capacity : 1) * sizeof(DATATYPE));
+  }
+
+  if (use_mmap){ // the slice is sorted straight from the mapped file into local_array
+    Mapped_file map;
+    init_time = Map_input(&map, size, n_rank, rank, filename, comm);
+    local_time_sort = init_local_sort_from(map.data, local_array, local_size, n_rank, comm);
+    Unmap_file(&map);
+  } else if (ingest_chunks != NULL || ingest_chunk != NULL){ // the read of a chunk overlaps the sort of the previous one
+    init_time = Pipelined_ingest(local_array, size, n_rank, rank, filename, VERSION, n_ingest, ingest_size,
+                                 comm, &local_time_sort, &hidden_time);
+  } else {
+    init_time = init(local_array, size, n_rank, rank, filename, VERSION, comm);
+    local_time_sort = init_local_sort(local_array, local_size, n_rank, comm);
+  }
 
   if(testMode && rank == 0)
-  if (rank == 0)
     printf("init time taken: %.3lf\n", init_time);
 
-  local_time_sort = init_local_sort(local_array, local_size, n_rank, rank, comm);
-
   if (testMode && rank == 0)
     printf("init local sort time taken: %.3lf\n", local_time_sort);
 
   if(testMode){
     if (rank == 0)
       printf("\n### PRIMA ###\n");
-    Print_global_list(local_array, local_size, rank, n_rank, comm);
+    Print_global_list_v(local_array, local_size, rank, n_rank, comm);
   }
 
-  Merge_sort(local_array, local_size, rank, n_rank, comm);
+  TRACE_BEGIN(t_global)
+  // the sorted slices may already be in order across the processes (presorted input):
+  // then the distributed results need no communication and the tree merges no merge
+  int in_order = Slices_in_order(local_array, size, rank, n_rank, comm);
+
+  if (MERGE_TYPE == 1){
+    if (!in_order)
+      local_size = Sample_sort(&local_array, local_size, rank, n_rank, comm);
+
+    if(testMode){
+      if (rank == 0)
+        printf("\n### DOPO ###\n");
+      Print_global_list_v(local_array, local_size, rank, n_rank, comm);
+    }
+  }else if (MERGE_TYPE == 4){
+    if (!in_order)
+      Merge_sort_path(&local_array, size, rank, n_rank, comm);
 
-  if(testMode && rank == 0){
-    printf("\n### DOPO ###\n");
-    Print_list(local_array, size);
+    if(testMode){
+      if (rank == 0)
+        printf("\n### DOPO ###\n");
+      Print_global_list_v(local_array, local_size, rank, n_rank, comm);
+    }
+  }else{
+    if (MERGE_TYPE == 3)
+      local_array = Hier_merge_sort(&hier);
+    else if (compress) // sorted runs travel encoded, presorted ones shrink the most
+      Merge_sort_compressed(&local_array, size, rank, n_rank, chunk, comm, &cstats);
+    else if (MERGE_TYPE == 2 && !in_order)
+      Merge_sort_pipelined(&local_array, size, rank, n_rank, chunk, comm);
+    else
+      Merge_sort(&local_array, size, rank, n_rank, comm);
+
+    if(testMode && rank == 0){
+      printf("\n### DOPO ###\n");
+      Print_list(local_array, size);
+    }
   }
-  
+  TRACE_END(t_global, "global_merge", -1, local_size * sizeof(DATATYPE));
+  // the global merge ends with the slowest process
+  double merge_local = MPI_Wtime() - t_global, merge_time = 0;
+  MPI_Reduce(&merge_local, &merge_time, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+  if (out_filename != NULL){
+    // after the tree merge the whole sorted list is on rank 0, sample sort and merge path keep it distributed
+    size_t out_size = (MERGE_TYPE == 1 || MERGE_TYPE == 4) ? local_size : (rank == 0 ? size : 0);
+    write_time = write_output(local_array, out_size, n_rank, rank, out_filename, VERSION, comm);
+
+    if (testMode && rank == 0)
+      printf("write time taken: %.3lf\n", write_time);
+  }
+
+  size_t bytes[2] = {cstats.raw_bytes, cstats.sent_bytes}, total_bytes[2] = {0, 0};
+  if (compress) // bytes of all the messages of the tree
+    MPI_Reduce(bytes, total_bytes, 2, MPI_SIZE_T, MPI_SUM, 0, comm);
+
   // OUTPUT
-  if (rank == 0)
-    printf("%d;%d;%lf;%lf",size,n_rank,init_time,local_time_sort);
+  if (rank == 0){
+    printf("%zu;%d;%lf;%lf;%lf",size,n_rank,init_time,local_time_sort,merge_time);
+    if (out_filename != NULL)
+      printf(";%lf",write_time);
+    if (ingest_chunks != NULL || ingest_chunk != NULL) // read time hidden under the local sort
+      printf(";%lf",hidden_time);
+    if (compress) // compression ratio and bytes not sent
+      printf(";%lf;%zu", (total_bytes[1] > 0) ? (double) total_bytes[0] / total_bytes[1] : 1.0,
+             total_bytes[0] - total_bytes[1]);
+  }
 
-  free(local_array);
+  if (MERGE_TYPE == 3)
+    Hier_free(&hier);
+  else
+    free(local_array);
+  Trace_finish(comm);
   MPI_Finalize();
 
   return EXIT_SUCCESS;
@@ -106,10 +321,11 @@ int main(int argc, char * argv[]) {
 
 /**
  * @brief Read the input data to be sorted from file and stores the result in memory.
+ * Each process reads its slice of the size elements of the file (see Slice_offset).
  * The time taken to read the file and fill the memory is returned;
  * 
  * @param local_array the array to be filled with data
- * @param local_size  the size of the array
+ * @param size the number of elements in the file
  * @param n_rank the size of the communicator
  * @param rank the rank of node in the communicator
  * @param filename name of the file to be read 
@@ -118,67 +334,400 @@ int main(int argc, char * argv[]) {
  * @return double the time spent to read the file and store the data in memory
  */
 
-double init(DATATYPE *local_array, int local_size, int n_rank, int rank, char* filename, int version, MPI_Comm com) {
+double init(DATATYPE *local_array, size_t size, int n_rank, int rank, char* filename, int version, MPI_Comm com) {
+  return Read_elements(local_array, size, MPITYPE, n_rank, rank, filename, version, com);
+}
+
+/**
+ * @brief Map the slice of each process of the input file instead of reading it
+ * (see Map_file): the processes of a node share the pages of the file in the
+ * page cache, and the local sort reads them straight from the mapping
+ * (see init_local_sort_from), so the slice is copied once, into the sorted array.
+ * On failure the communicator is aborted.
+ * 
+ * @param map the mapping of the slice, to be released with Unmap_file
+ * @param size the number of elements in the file
+ * @param n_rank the size of the communicator
+ * @param rank the rank of node in the communicator
+ * @param filename name of the file to be mapped
+ * @param com the MPI communicator involved 
+ * @return double the mean time spent by the processes to map (and load) the slice
+ */
+double Map_input(Mapped_file* map, size_t size, int n_rank, int rank, const char* filename, MPI_Comm com) {
+  size_t first = Slice_offset(size, rank, n_rank);
+  size_t local_size = Slice_offset(size, rank + 1, n_rank) - first;
+  double start,end,sum;
+
+  START_T(start)
+  if (Map_file(filename, first * sizeof(DATATYPE), local_size * sizeof(DATATYPE), map) != 0){
+    fprintf(stderr,"can't map %s: %s\n", filename, strerror(errno));
+    MPI_Abort(com, EXIT_FAILURE);
+  }
+  END_T(end,start,com,sum,"map",local_size * sizeof(DATATYPE))
+
+  return sum/n_rank;
+}
+
+/**
+ * @brief Read the slice of each process of a file of size elements of elem_type (see init).
+ * 
+ * @param local_array the buffer to be filled with data
+ * @param size the number of elements in the file
+ * @param elem_type the MPI datatype of an element (contiguous)
+ * @param n_rank the size of the communicator
+ * @param rank the rank of node in the communicator
+ * @param filename name of the file to be read 
+ * @param version changes the read mode
+ * @param com the MPI communicator involved 
+ * @return double the time spent to read the file and store the data in memory
+ */
+double Read_elements(void* local_array, size_t size, MPI_Datatype elem_type, int n_rank, int rank, char* filename, int version, MPI_Comm com) {
 
   MPI_Status status;
   MPI_File fh;
+  size_t first = Slice_offset(size, rank, n_rank);
+  size_t local_size = Slice_offset(size, rank + 1, n_rank) - first;
+  int count;
+  MPI_Aint lb, elem_size;
+  MPI_Datatype type = Large_type(local_size, elem_type, &count); // (count, type) describe local_size elements
 
   double start,end,sum;
 
+  MPI_Type_get_extent(elem_type, &lb, &elem_size);
+
   //start counting time
   START_T(start)
 
   if (version == 0 || version == 1){ // contiguous requests
-    MPI_Offset offset = rank * local_size * sizeof(DATATYPE);
+    MPI_Offset offset = (MPI_Offset) first * elem_size;
+    TRACE_BEGIN(t_open)
     MPI_File_open(com, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    TRACE_END(t_open, "open", -1, 0);
     // for (int i=0; i<n_rank; i++){
       MPI_File_seek(fh, offset, MPI_SEEK_SET);
       if (version == 0) // many independent, contiguous requests
-        MPI_File_read(fh, local_array, local_size, MPITYPE, &status);
+        MPI_File_read(fh, local_array, count, type, &status);
       else // version 1 many collective, contiguous requests
-        MPI_File_read_all(fh, local_array, local_size, MPITYPE, &status);
+        MPI_File_read_all(fh, local_array, count, type, &status);
     // }
     MPI_File_close(&fh);
 
   } else if (version == 2 || version == 3){ // noncontiguous request
-    MPI_Datatype array_integer_type;
-    MPI_Type_contiguous(local_size, MPITYPE , &array_integer_type);
-    MPI_Type_commit(&array_integer_type);
+    MPI_Datatype array_integer_type = Contiguous_large(local_size, elem_type);
 
-    int displacement = rank * local_size * sizeof(DATATYPE);
+    MPI_Offset displacement = (MPI_Offset) first * elem_size;
 
-    MPI_File_open(com, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);  
-    MPI_File_set_view(fh, displacement, MPITYPE, array_integer_type, "native", MPI_INFO_NULL);
+    TRACE_BEGIN(t_open)
+    MPI_File_open(com, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    TRACE_END(t_open, "open", -1, 0);
+    MPI_File_set_view(fh, displacement, elem_type, array_integer_type, "native", MPI_INFO_NULL);
     if(version == 2) // single independent, noncontiguous request
-      MPI_File_read(fh, local_array, local_size, MPITYPE, &status);
+      MPI_File_read(fh, local_array, count, type, &status);
     else // version 3 : single collective, noncontiguous request
-      MPI_File_read_all(fh, local_array, local_size, MPITYPE, &status);
+      MPI_File_read_all(fh, local_array, count, type, &status);
     MPI_File_close(&fh);
+    MPI_Type_free(&array_integer_type);
+  }
+  Free_large_type(&type, elem_type);
+  //stop the timer
+  END_T(end,start,com,sum,"read",local_size * elem_size)
+
+  return sum/n_rank; //return the mean of the time spent in this function by each node in the communicator
+}
+
+/**
+ * @brief Write the sorted data to file, each process writes its own
+ * part of the list right after the parts of the processes with lower rank.
+ * The write mode mirrors the read mode of init().
+ * The time taken to write the file is returned;
+ * 
+ * @param local_array the array to be written
+ * @param local_size  the size of the array (may differ between processes)
+ * @param n_rank the size of the communicator
+ * @param rank the rank of node in the communicator
+ * @param filename name of the file to be written
+ * @param version changes the write mode
+ * @param com the MPI communicator involved 
+ * @return double the time spent to write the data on file
+ */
+double write_output(DATATYPE *local_array, size_t local_size, int n_rank, int rank, const char* filename, int version, MPI_Comm com) {
+  return Write_elements(local_array, local_size, MPITYPE, n_rank, rank, filename, version, com);
+}
+
+/**
+ * @brief Write local_size elements of elem_type per process to file (see write_output).
+ * 
+ * @param local_array the buffer to be written
+ * @param local_size  the number of elements to write (may differ between processes)
+ * @param elem_type the MPI datatype of an element (contiguous)
+ * @param n_rank the size of the communicator
+ * @param rank the rank of node in the communicator
+ * @param filename name of the file to be written
+ * @param version changes the write mode
+ * @param com the MPI communicator involved 
+ * @return double the time spent to write the data on file
+ */
+double Write_elements(const void* local_array, size_t local_size, MPI_Datatype elem_type, int n_rank, int rank, const char* filename, int version, MPI_Comm com) {
+
+  MPI_Status status;
+  MPI_File fh;
+  size_t preceding = 0, total = 0;
+  int count;
+  MPI_Aint lb, elem_size;
+  MPI_Datatype type = Large_type(local_size, elem_type, &count); // (count, type) describe local_size elements
+
+  double start,end,sum;
+
+  MPI_Type_get_extent(elem_type, &lb, &elem_size);
+
+  //start counting time
+  START_T(start)
+
+  // position of the local part in the file
+  MPI_Exscan(&local_size, &preceding, 1, MPI_SIZE_T, MPI_SUM, com);
+  if (rank == 0)
+    preceding = 0; // MPI_Exscan leaves it undefined on rank 0
+  MPI_Allreduce(&local_size, &total, 1, MPI_SIZE_T, MPI_SUM, com);
+
+  MPI_File_open(com, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+  MPI_File_set_size(fh, (MPI_Offset) total * elem_size); // truncate stale content
+
+  if (version == 0 || version == 1){ // contiguous requests
+    MPI_Offset offset = (MPI_Offset) preceding * elem_size;
+    MPI_File_seek(fh, offset, MPI_SEEK_SET);
+    if (version == 0) // many independent, contiguous requests
+      MPI_File_write(fh, local_array, count, type, &status);
+    else // version 1 many collective, contiguous requests
+      MPI_File_write_all(fh, local_array, count, type, &status);
+
+  } else if (version == 2 || version == 3){ // noncontiguous request
+    MPI_Datatype array_integer_type = Contiguous_large(local_size, elem_type);
+
+    MPI_Offset displacement = (MPI_Offset) preceding * elem_size;
+
+    MPI_File_set_view(fh, displacement, elem_type, array_integer_type, "native", MPI_INFO_NULL);
+    if(version == 2) // single independent, noncontiguous request
+      MPI_File_write(fh, local_array, count, type, &status);
+    else // version 3 : single collective, noncontiguous request
+      MPI_File_write_all(fh, local_array, count, type, &status);
+    MPI_Type_free(&array_integer_type);
   }
+  MPI_File_close(&fh);
+  Free_large_type(&type, elem_type);
+
   //stop the timer
-  END_T(end,start,com,sum)
+  END_T(end,start,com,sum,"write",local_size * elem_size)
 
   return sum/n_rank; //return the mean of the time spent in this function by each node in the communicator
 }
 
-double init_local_sort(DATATYPE* local_array, int local_size, int n_rank, int rank, MPI_Comm com){
+double init_local_sort(DATATYPE* local_array, size_t local_size, int n_rank, MPI_Comm com){
+  return init_local_sort_from(local_array, local_array, local_size, n_rank, com);
+}
+
+/**
+ * @brief Sort the slice in (e.g. the mapped input, see Map_input) into local_array
+ * (see local_sort_from), the time spent is returned.
+ * 
+ * @param in the slice to be sorted (local_array for an in place sort)
+ * @param local_array the destination of the sorted slice
+ * @param local_size the size of the slice
+ * @param n_rank the size of the communicator
+ * @param com the MPI communicator involved 
+ * @return double the mean time spent by the processes to sort
+ */
+double init_local_sort_from(const DATATYPE* in, DATATYPE* local_array, size_t local_size, int n_rank, MPI_Comm com){
   
   double start_time,end_time,sum;
 
   START_T(start_time)
     //sort the local array 
-    if(SORT_TYPE == 0){
-      mergesort_rec(local_array,local_size);
-    }else{
-      //qsort(local_array, local_size, sizeof(local_array[0]), Compare);
-      quickSort(local_array,0,local_size-1); 
-    }
+    local_sort_from(in, local_array, local_size);
     
-  END_T(end_time,start_time,com,sum)
+  END_T(end_time,start_time,com,sum,"local_sort",local_size * sizeof(DATATYPE))
 
   return sum / n_rank; 
 }
 
+// start of chunk c of a slice of local_size elements cut in chunks of chunk elements
+static inline size_t chunk_bound(size_t c, size_t chunk, size_t local_size){
+  return (c * chunk < local_size) ? c * chunk : local_size;
+}
+
+/**
+ * @brief Issue the nonblocking read of the elements [lo, hi) of the slice that
+ * starts at element first of the file into buf + lo (collective when collective).
+ */
+static void ingest_issue(MPI_File fh, DATATYPE* buf, size_t first, size_t lo, size_t hi, int collective,
+                         MPI_Request* request, MPI_Datatype* type){
+  int count;
+  MPI_Offset offset = (MPI_Offset) ((first + lo) * sizeof(DATATYPE));
+
+  *type = Large_type(hi - lo, MPITYPE, &count);
+  if (collective)
+    MPI_File_iread_at_all(fh, offset, buf + lo, count, *type, request);
+  else
+    MPI_File_iread_at(fh, offset, buf + lo, count, *type, request);
+}
+
+/**
+ * @brief Read the slice of each process by chunks with nonblocking MPI-IO and
+ * sort each chunk while the next one is read, then merge the sorted chunks
+ * into local_array. The chunks are chunk elements (n_chunks per slice when
+ * chunk is 0); every process issues the same number of reads, collective for
+ * VERSION 1 and 3, independent for VERSION 0 and 2.
+ * The hidden time of a chunk is the part of its read that ran under the sort
+ * of the previous chunk: its expected read time (at the rate of the first
+ * chunk, read with nothing to overlap) minus the time waited for it, bounded
+ * by that sort.
+ * 
+ * @param local_array the destination of the sorted slice
+ * @param size the number of elements in the file
+ * @param n_rank the size of the communicator
+ * @param rank the rank of node in the communicator
+ * @param filename name of the file to be read
+ * @param version the read mode (see init)
+ * @param n_chunks chunks of the largest slice (used when chunk is 0)
+ * @param chunk elements of a chunk, 0 to use n_chunks
+ * @param com the MPI communicator involved 
+ * @param sort_time output: mean time spent to sort the chunks and merge them
+ * @param hidden_time output: mean read time hidden under the sort
+ * @return double the mean read time not hidden (issuing and waiting for the reads)
+ */
+double Pipelined_ingest(DATATYPE* local_array, size_t size, int n_rank, int rank, char* filename, int version,
+                        size_t n_chunks, size_t chunk, MPI_Comm com, double* sort_time, double* hidden_time){
+  size_t first = Slice_offset(size, rank, n_rank);
+  size_t local_size = Slice_offset(size, rank + 1, n_rank) - first;
+  size_t max_size = size / n_rank + (size % n_rank != 0); // largest slice: fixes the number of reads
+  int collective = (version == 1 || version == 3);
+  double local[3] = {0, 0, 0}, sum[3]; // read not hidden, sort, hidden
+  double t, wait, first_read = 0, rate = 0, last_sort = 0;
+  MPI_File fh;
+  MPI_Request request;
+  MPI_Datatype type;
+
+  if (chunk == 0 && n_chunks > 0)
+    chunk = (max_size + n_chunks - 1) / n_chunks;
+  if (chunk == 0)
+    chunk = 1;
+  n_chunks = (max_size + chunk - 1) / chunk;
+
+  // the chunks are merged in pairs, alternating the buffers: read them into the
+  // one that makes the last pass end in local_array
+  int passes = 0;
+  for (size_t w = 1; w < n_chunks; w *= 2)
+    passes++;
+  DATATYPE* staging = (passes > 0) ? malloc((local_size > 0 ? local_size : 1) * sizeof(DATATYPE)) : NULL;
+  DATATYPE* buf = (passes % 2) ? staging : local_array;
+
+  t = MPI_Wtime();
+  MPI_File_open(com, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+  local[0] += MPI_Wtime() - t;
+  t = MPI_Wtime();
+  if (n_chunks > 0)
+    ingest_issue(fh, buf, first, 0, chunk_bound(1, chunk, local_size), collective, &request, &type);
+  first_read = MPI_Wtime() - t;
+  local[0] += first_read;
+
+  for (size_t c = 0; c < n_chunks; c++) {
+    size_t lo = chunk_bound(c, chunk, local_size), hi = chunk_bound(c + 1, chunk, local_size);
+
+    TRACE_BEGIN(t_wait)
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+    Free_large_type(&type, MPITYPE);
+    wait = MPI_Wtime() - t_wait;
+    TRACE_END(t_wait, "ingest_wait", (int) c, (hi - lo) * sizeof(DATATYPE));
+    local[0] += wait;
+    if (c == 0) // nothing to overlap with: the rate of the reads
+      rate = (hi > lo) ? (first_read + wait) / (hi - lo) : 0;
+    else {
+      double expected = rate * (hi - lo);
+      double hidden = (expected > wait) ? expected - wait : 0;
+      local[2] += (hidden < last_sort) ? hidden : last_sort;
+    }
+
+    t = MPI_Wtime();
+    if (c + 1 < n_chunks) // the next read runs while this chunk is sorted
+      ingest_issue(fh, buf, first, hi, chunk_bound(c + 2, chunk, local_size), collective, &request, &type);
+    local[0] += MPI_Wtime() - t;
+
+    TRACE_BEGIN(t_sort)
+    local_sort(buf + lo, hi - lo);
+    last_sort = MPI_Wtime() - t_sort;
+    TRACE_END(t_sort, "local_sort", (int) c, (hi - lo) * sizeof(DATATYPE));
+    local[1] += last_sort;
+  }
+  MPI_File_close(&fh);
+
+  // pairwise merges of the sorted chunks
+  TRACE_BEGIN(t_merge)
+  DATATYPE *src = buf, *dst = (buf == staging) ? local_array : staging, *tmp;
+  for (size_t w = 1; w < n_chunks; w *= 2) {
+    for (size_t c = 0; c < n_chunks; c += 2 * w) {
+      size_t lo = chunk_bound(c, chunk, local_size);
+      size_t mid = chunk_bound(c + w, chunk, local_size);
+      size_t hi = chunk_bound(c + 2 * w, chunk, local_size);
+      merge_ranges(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+    }
+    tmp = src; src = dst; dst = tmp;
+  }
+  local[1] += MPI_Wtime() - t_merge;
+  TRACE_END(t_merge, "ingest_merge", -1, local_size * sizeof(DATATYPE));
+  free(staging);
+
+  MPI_Reduce(local, sum, 3, MPI_DOUBLE, MPI_SUM, 0, com);
+  *sort_time = sum[1] / n_rank;
+  *hidden_time = sum[2] / n_rank;
+  return sum[0] / n_rank;
+}
+
+/**
+ * @brief Select the algorithm and the threads of local_sort (see SORT_TYPE),
+ * for the callers that do not go through sort_main.
+ * 
+ * @param sort_type the local sort algorithm (SORT_TYPE)
+ * @param n_threads threads of the merge sort
+ */
+void Select_local_sort(int sort_type, int n_threads){
+  SORT_TYPE = sort_type;
+  N_THREADS = n_threads;
+}
+
+/**
+ * @brief Sort an array with the local sort algorithm selected by SORT_TYPE
+ * (0 merge sort, 1 quick sort (pdqsort), 2 radix sort, 3 natural merge sort for presorted inputs), the merge sort uses N_THREADS threads
+ * 
+ * @param local_array the array to be sorted
+ * @param local_size the size of the array
+ */
+void local_sort(DATATYPE* local_array, size_t local_size){
+  local_sort_from(local_array, local_array, local_size);
+}
+
+/**
+ * @brief Out-of-place local_sort: the n elements of in are sorted into out.
+ * The merge sort and the radix sort fuse the copy with their first pass,
+ * quick sort and natural merge sort work in place, so in is copied first.
+ * 
+ * @param in the array to be sorted (not modified when it is not out)
+ * @param out the destination of the sorted array
+ * @param n the size of the array
+ */
+void local_sort_from(const DATATYPE* in, DATATYPE* out, size_t n){
+  if(SORT_TYPE == 0){
+    mergesort_par_from(in,out,n,N_THREADS);
+  }else if(SORT_TYPE == 2){
+    radix_sort_from(in,out,n);
+  }else{
+    if (in != out)
+      memcpy(out, in, n * sizeof(DATATYPE));
+    if(SORT_TYPE == 3)
+      run_sort(out,n);
+    else
+      pdq_sort(out,n);
+  }
+}
+
 /**
  * @brief Print the contents of a distributed list 
  * 
@@ -188,9 +737,10 @@ double init_local_sort(DATATYPE* local_array, int local_size, int n_rank, int ra
  * @param n_rank size of communicator
  * @param comm the communicator 
  */
-void Print_global_list(DATATYPE* local_array, int local_n, int rank, int n_rank, MPI_Comm comm) {
+void Print_global_list(DATATYPE* local_array, size_t local_n, int rank, int n_rank, MPI_Comm comm) {
   DATATYPE* global_A = NULL;
 
+  // only meant for small lists (test mode): int counts are enough
   if (rank == 0) {
     global_A = malloc(n_rank * local_n * sizeof(DATATYPE));
     MPI_Gather(local_array, local_n, MPITYPE, global_A, local_n, MPITYPE, 0, comm);
@@ -202,6 +752,47 @@ void Print_global_list(DATATYPE* local_array, int local_n, int rank, int n_rank,
   }
 }
 
+/**
+ * @brief Print the contents of a distributed list whose
+ * local parts may have different sizes (e.g. after sample sort)
+ * 
+ * @param local_array the local list
+ * @param local_n the number of elements in the local list
+ * @param rank rank of the process in the communicator
+ * @param n_rank size of communicator
+ * @param comm the communicator 
+ */
+void Print_global_list_v(DATATYPE* local_array, size_t local_n, int rank, int n_rank, MPI_Comm comm) {
+  DATATYPE* global_A = NULL;
+  int *counts = NULL, *displs = NULL;
+  int i, total = 0, n = (int) local_n; // only meant for small lists (test mode)
+
+  if (rank == 0) {
+    counts = malloc(n_rank * sizeof(int));
+    displs = malloc(n_rank * sizeof(int));
+  }
+  MPI_Gather(&n, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+
+  if (rank == 0) {
+    for (i = 0; i < n_rank; i++) {
+      displs[i] = total;
+      total += counts[i];
+    }
+    global_A = malloc((total > 0 ? total : 1) * sizeof(DATATYPE));
+  }
+  MPI_Gatherv(local_array, n, MPITYPE, global_A, counts, displs, MPITYPE, 0, comm);
+
+  if (rank == 0) {
+    for (i = 0; i < n_rank; i++) {
+      printf("\n#Node %d\n", i);
+      Print_list(global_A + displs[i], counts[i]);
+    }
+    free(global_A);
+    free(counts);
+    free(displs);
+  }
+}
+
 /**
  * @brief Print a list of DATATYPE to stdout;
  * each element is represented as a double with 
@@ -211,170 +802,431 @@ void Print_global_list(DATATYPE* local_array, int local_n, int rank, int n_rank,
  * @param local_array the array to be printed
  * @param n the size of the array 
  */
-void Print_list(DATATYPE local_array[], int n) {
-  int i;
+void Print_list(DATATYPE local_array[], size_t n) {
+  size_t i;
   for (i = 0; i < n; i++)
-    printf("%.2lf ", (double)local_array[i]);
+    printf(DATATYPE_FMT " ", local_array[i]);
   printf("\n");
 }
 
-void Print_list_node(DATATYPE local_array[], int n, int local_size) {
-  int i, j = 0;
+void Print_list_node(DATATYPE local_array[], size_t n, size_t local_size) {
+  size_t i;
+  int j = 0;
   for (i = 0; i < n; i++){
     if (i%local_size == 0)
       printf("\n#Node %d\n",j++);    
-    printf("%.2lf ", (double)local_array[i]);
+    printf(DATATYPE_FMT " ", local_array[i]);
   }
   printf("\n");
 }
 
+/**
+ * @brief First element of the slice of rank when size elements are split among
+ * n_rank processes: the slices differ by at most one element, and the slice
+ * of rank is [Slice_offset(size, rank, n_rank), Slice_offset(size, rank + 1, n_rank)).
+ * 
+ * @param size the number of elements of the global list
+ * @param rank rank of the process (n_rank gives size)
+ * @param n_rank size of communicator
+ * @return size_t the offset of the slice in the global list
+ */
+size_t Slice_offset(size_t size, int rank, int n_rank) {
+  return (size_t)((unsigned long long) rank * size / n_rank);
+}
+
+/**
+ * @brief Tree merge for any number of processes: [0, n_rank) is split in two
+ * halves differing by at most one rank, recursively; the first rank of the
+ * second half sends to the first rank of the first half the merge of its half.
+ * So the tree has ceil(log2(n_rank)) levels and, the slices being balanced
+ * too, the lists merged at each level differ by at most a factor of two.
+ * 
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @return Merge_tree the parent, children and subtree of the process
+ */
+Merge_tree Merge_schedule(int rank, int n_rank) {
+  Merge_tree tree = { .parent = -1, .n_children = 0, .end = n_rank };
+  int child[MERGE_TREE_DEPTH], child_end[MERGE_TREE_DEPTH], k = 0;
+  int lo = 0, hi = n_rank;
+
+  // descend the splits of [0, n_rank) containing rank, the receives of the root lo top-down
+  while (hi - lo > 1) {
+    int mid = lo + (hi - lo + 1) / 2;
+    if (rank < mid) {
+      if (rank == lo) {
+        child[k] = mid;
+        child_end[k] = hi;
+        k++;
+      }
+      hi = mid;
+    } else {
+      if (rank == mid) { // root of [mid, hi) from here on
+        tree.parent = lo;
+        tree.end = hi;
+      }
+      lo = mid;
+    }
+  }
+
+  // the deepest (smallest) merges come first
+  for (int i = 0; i < k; i++) {
+    tree.child[i] = child[k - 1 - i];
+    tree.child_end[i] = child_end[k - 1 - i];
+  }
+  tree.n_children = k;
+  return tree;
+}
+
+/**
+ * @brief Check if the sorted slices of the processes are in order across the ranks
+ * (the last element of each nonempty slice <= the first of the next one),
+ * exchanging only the first and the last element of each slice.
+ * 
+ * @param local_array the sorted slice of the process (see Slice_offset)
+ * @param size the number of elements of the global list
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
+ * @return int 1 if the global list is already sorted, the same on every process
+ */
+int Slices_in_order(const DATATYPE* local_array, size_t size, int rank, int n_rank, MPI_Comm comm) {
+  size_t n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  DATATYPE bounds[2] = { 0, 0 };
+  DATATYPE* all = malloc(2 * n_rank * sizeof(DATATYPE));
+  int in_order = 1, prev = -1;
+
+  if (n > 0) {
+    bounds[0] = local_array[0];
+    bounds[1] = local_array[n - 1];
+  }
+  MPI_Allgather(bounds, 2, MPITYPE, all, 2, MPITYPE, comm);
+
+  for (int r = 0; r < n_rank && in_order; r++) {
+    if (Slice_offset(size, r + 1, n_rank) == Slice_offset(size, r, n_rank))
+      continue; // empty slice
+    if (prev >= 0 && all[2 * r] < all[2 * prev + 1])
+      in_order = 0;
+    prev = r;
+  }
+  free(all);
+  return in_order;
+}
+
+/**
+ * @brief Number of elements a process holds at the end of the tree merge:
+ * the slices of all the ranks of its subtree (see Merge_schedule).
+ * Leaves only need their own slice, rank 0 needs the whole list.
+ * 
+ * @param size the number of elements of the global list
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @return size_t the number of elements of the buffers of the process
+ */
+size_t Merge_buffer_size(size_t size, int rank, int n_rank) {
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+
+  return Slice_offset(size, tree.end, n_rank) - Slice_offset(size, rank, n_rank);
+}
+
 /**
  * @brief Parallel merge sort: starts with a distributed
  * collection of sorted lists, produces a global sorted list on process
- * with rank 0. Uses tree-structured communication.
+ * with rank 0. Uses tree-structured communication, balanced for any
+ * number of processes (see Merge_schedule).
  * 
- * @param local_array the sorted array from the process; the global sorted array will be saved here  
- * @param local_n the size of the array
+ * The list of the partner is received right after the local one, the merge
+ * goes to a second buffer of the same size and the two buffers are swapped
+ * (ping-pong), so no copy back is needed.
+ * 
+ * PRE: *local_array holds the slice of the process (see Slice_offset)
+ * in a buffer of Merge_buffer_size(size, rank, n_rank) elements
+ * 
+ * @param local_array pointer to the sorted array from the process; at the end
+ * it points to the global sorted array (the buffer may have been swapped)
+ * @param size the number of elements of the global list
  * @param rank rank of the process
  * @param n_rank size of communicator
  * @param comm the communicator
  */
-void Merge_sort(DATATYPE* local_array, int local_n, int rank, int n_rank, MPI_Comm comm) {
-  int partner, done = 0, size = local_n;
-  unsigned bitmask = 1;
-  DATATYPE *B, *C;
-  MPI_Status status;
+void Merge_sort(DATATYPE** local_array, size_t size, int rank, int n_rank, MPI_Comm comm) {
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+  size_t n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t cap = Merge_buffer_size(size, rank, n_rank);
+  DATATYPE *A = *local_array, *C = NULL, *tmp;
 
-  B = malloc(n_rank * local_n * sizeof(DATATYPE));
-  C = malloc(n_rank * local_n * sizeof(DATATYPE));
-
-  while (!done && bitmask < n_rank) {
-    partner = rank ^ bitmask;
-    if (rank > partner) { // process send to partner
-      MPI_Send(local_array, size, MPITYPE, partner, 0, comm);
-      done = 1;
-    } else { // process receive from partner 
-      MPI_Recv(B, size, MPITYPE, partner, 0, comm, & status);
-      Merge(local_array, B, C, size);
-      size = 2 * size;
-      bitmask <<= 1;
+  if (tree.n_children > 0) // leaves only send: no second buffer
+    C = malloc(cap * sizeof(DATATYPE));
+
+  for (int k = 0; k < tree.n_children; k++) { // process receive from its children
+    size_t nb = Slice_offset(size, tree.child_end[k], n_rank) - Slice_offset(size, tree.child[k], n_rank);
+    TRACE_BEGIN(t_recv)
+    Recv_large(A + n, nb, MPITYPE, tree.child[k], 0, comm);
+    TRACE_END(t_recv, "recv", k, nb * sizeof(DATATYPE));
+    if (n > 0 && nb > 0 && A[n] < A[n - 1]) { // otherwise A + n is already the merge
+      TRACE_BEGIN(t_merge)
+      Merge(A, n, A + n, nb, C);
+      TRACE_END(t_merge, "merge", k, (n + nb) * sizeof(DATATYPE));
+      tmp = A; A = C; C = tmp;
     }
+    n += nb;
+  }
+  if (tree.parent >= 0) { // process send to its parent
+    TRACE_BEGIN(t_send)
+    Send_large(A, n, MPITYPE, tree.parent, 0, comm);
+    TRACE_END(t_send, "send", tree.n_children, n * sizeof(DATATYPE));
   }
 
-  free(B); // No memory leaks!
-  free(C);
-} 
+  *local_array = A;
+  free(C); // No memory leaks!
+}
 
 /**
- * @brief Merge two sorted lists, A and B. Return result in A.
- * C is used for scratch. Both A and B have size elements.
+ * @brief Pipelined version of Merge_sort: the sorted list is sent in chunks
+ * of nonblocking sends and the receiver merges each chunk as soon as it arrives,
+ * while the following ones are still in transit (see Merge_stream).
  * 
- * @param A first input array
- * @param B second input array
- * @param C temporary array for merged lists
- * @param size dimen of the three arrays
+ * PRE: *local_array holds the slice of the process (see Slice_offset)
+ * in a buffer of Merge_buffer_size(size, rank, n_rank) elements
+ * 
+ * @param local_array pointer to the sorted array from the process; at the end
+ * it points to the global sorted array (the buffer may have been swapped)
+ * @param size the number of elements of the global list
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param chunk number of elements in each message
+ * @param comm the communicator
  */
-void Merge(DATATYPE* A, DATATYPE* B, DATATYPE* C, int size) {
-  int ai, bi, ci;
-
-  ai = bi = ci = 0;
-  while (ai < size && bi < size)
-    if (A[ai] <= B[bi]) {
-      C[ci] = A[ai];
-      ci++;
-      ai++;
-    } else {
-      C[ci] = B[bi];
-      ci++;
-      bi++;
+void Merge_sort_pipelined(DATATYPE** local_array, size_t size, int rank, int n_rank, size_t chunk, MPI_Comm comm) {
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+  size_t n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t cap = Merge_buffer_size(size, rank, n_rank);
+  DATATYPE *A = *local_array, *C = NULL, *tmp;
+
+  if (chunk == 0 || chunk > LARGE_COUNT_LIMIT)
+    chunk = PIPELINE_CHUNK;
+
+  if (tree.n_children > 0) // leaves only send: no second buffer
+    C = malloc(cap * sizeof(DATATYPE));
+
+  for (int k = 0; k < tree.n_children; k++) { // process receive from its children while merging
+    size_t nb = Slice_offset(size, tree.child_end[k], n_rank) - Slice_offset(size, tree.child[k], n_rank);
+    TRACE_BEGIN(t_stream)
+    Merge_stream(A, n, C, nb, chunk, tree.child[k], comm);
+    TRACE_END(t_stream, "recv_merge", k, nb * sizeof(DATATYPE));
+    tmp = A; A = C; C = tmp;
+    n += nb;
+  }
+  if (tree.parent >= 0) { // process send to its parent
+    TRACE_BEGIN(t_send)
+    size_t n_chunks = (n + chunk - 1) / chunk;
+    MPI_Request* reqs = malloc((n_chunks > 0 ? n_chunks : 1) * sizeof(MPI_Request));
+
+    for (size_t c = 0; c < n_chunks; c++) {
+      size_t len = (c == n_chunks - 1) ? n - c * chunk : chunk;
+      MPI_Isend(A + c * chunk, (int) len, MPITYPE, tree.parent, 0, comm, &reqs[c]);
     }
+    MPI_Waitall((int) n_chunks, reqs, MPI_STATUSES_IGNORE);
+    free(reqs);
+    TRACE_END(t_send, "send", tree.n_children, n * sizeof(DATATYPE));
+  }
 
-  if (ai >= size)
-    for (; ci < 2 * size; ci++, bi++)
-      C[ci] = B[bi];
-  else
-    for (; ci < 2 * size; ci++, ai++)
-      C[ci] = A[ai];
-      
-  memcpy(A, C, 2 * size * sizeof(DATATYPE));
-} 
+  *local_array = A;
+  free(C);
+}
+
+// rank owning the global position pos (the slices may be empty when size < n_rank)
+static int path_owner(size_t pos, size_t size, int n_rank) {
+  int q = (int)((unsigned long long) pos * n_rank / size);
+  while (q + 1 < n_rank && Slice_offset(size, q + 1, n_rank) <= pos)
+    q++;
+  while (q > 0 && Slice_offset(size, q, n_rank) > pos)
+    q--;
+  return q;
+}
+
+// get the global positions [first, last) from their owners (completed by MPI_Win_flush_all)
+static void path_get(DATATYPE* dst, size_t first, size_t last, size_t size, int n_rank, MPI_Win win) {
+  while (first < last) {
+    int q = path_owner(first, size, n_rank), count;
+    size_t q_first = Slice_offset(size, q, n_rank), q_last = Slice_offset(size, q + 1, n_rank);
+    size_t len = ((last < q_last) ? last : q_last) - first;
+    MPI_Datatype type = Large_type(len, MPITYPE, &count);
+
+    MPI_Get(dst, count, type, q, (MPI_Aint)(first - q_first), count, type, win);
+    Free_large_type(&type, MPITYPE);
+    dst += len;
+    first += len;
+  }
+}
+
+// co_rank of the run A = [a, a + na) and B = [a + na, a + na + nb) of the global positions
+static size_t path_co_rank(size_t d, size_t a, size_t na, size_t nb, size_t size, int n_rank, MPI_Win win) {
+  size_t lo = (d > nb) ? d - nb : 0;
+  size_t hi = (d < na) ? d : na;
+  DATATYPE ai, bj;
+
+  while (lo < hi) {
+    size_t i = lo + (hi - lo) / 2;
+    size_t j = d - i; // j > 0 and i < na in the search range
+    path_get(&ai, a + i, a + i + 1, size, n_rank, win);
+    path_get(&bj, a + na + j - 1, a + na + j, size, n_rank, win);
+    MPI_Win_flush_all(win);
+    if (!(bj < ai))
+      lo = i + 1;
+    else
+      hi = i;
+  }
+  return lo;
+}
 
 /**
- * @brief Implementation of iterative-recursive quicksort. 
- * The recursion is executed only on the shorter array to be 
- * sorted, so the recursive call are reduced and the system stack
- * instead of the heap can be used.
+ * @brief Merge path version of Merge_sort: the result stays distributed,
+ * every process owning its slice of the global sorted list (see Slice_offset).
+ * At each level of the tree the ranks [lo, hi) of the two merged runs all take
+ * part in the merge: each process finds by co-rank (a binary search on the
+ * remote runs, through one-sided MPI_Get) which parts of the two runs make
+ * its slice of the merged run, gets them and merges them.
+ * So every process merges local_n elements per level, instead of the root
+ * merging all the list while the processes that have sent their list idle.
  * 
- * adapted from https://it.wikipedia.org/wiki/Quicksort
- * 
- * @param list the list to be sorted 
- * @param lo lower part of the list to be sorted
- * @param hi higher part of the list to be sorted
+ * @param local_array pointer to the sorted slice of the process; at the end
+ * it points to the slice of the global sorted list (the buffer may have been swapped)
+ * @param size the number of elements of the global list
+ * @param rank rank of the process
+ * @param n_rank size of communicator
+ * @param comm the communicator
  */
+void Merge_sort_path(DATATYPE** local_array, size_t size, int rank, int n_rank, MPI_Comm comm) {
+  size_t first = Slice_offset(size, rank, n_rank);
+  size_t n = Slice_offset(size, rank + 1, n_rank) - first;
+  DATATYPE *A = *local_array, *tmp;
+  DATATYPE *C = malloc((n > 0 ? n : 1) * sizeof(DATATYPE));
+  DATATYPE *pieces = malloc((n > 0 ? n : 1) * sizeof(DATATYPE));
+  MPI_Win win;
 
-void quickSort(DATATYPE* list, int lo, int hi) {
-    DATATYPE pivot;
-    
-    int  l,r,p;
+  for (int w = 1; w < n_rank; w *= 2) {
+    // ranks [lo, mid) hold run A, ranks [mid, hi) run B
+    int lo = rank / (2 * w) * (2 * w);
+    int mid = (lo + w < n_rank) ? lo + w : n_rank;
+    int hi = (lo + 2 * w < n_rank) ? lo + 2 * w : n_rank;
 
-      while (lo < hi) {   // The while loop replaces the second recursive call
-    
-        l = lo; p = (lo+hi)/2; r = hi;
-        pivot = list[p];
-
-        while (1){
-            while ((l<=r) && (compare(&list[l],&pivot) <= 0)) l++;
-            while ((l<=r) && (compare(&list[r],&pivot)  > 0)) r--;
-
-            if (l>r) break;
-            
-            //swap list[l] & list[r]
-            DATATYPE tmp = list[l];
-            list[l] = list[r];
-            list[r] = tmp;
-
-            if (p == r){
-              p = l;
-            }
-            
-            l++;
-            r--;
-        }
-
-        list[p] = list[r];
-        list[r] = pivot;
-        r--;
-
-        // Select the shorter side of the array & call recursion
-        if ((r-lo)<(hi-l)) {
-            quickSort(list, lo, r);
-            lo=l;
-        }
-        else {
-            quickSort(list, l, hi);
-            hi = r;
-        }
-    }   
+    int level = 0;
+    for (int l = 1; l < w; l *= 2) level++;
+
+    MPI_Win_create(A, (MPI_Aint)(n * sizeof(DATATYPE)), sizeof(DATATYPE), MPI_INFO_NULL, comm, &win);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    if (mid < hi) { // otherwise run A is already in place
+      size_t a = Slice_offset(size, lo, n_rank);
+      size_t na = Slice_offset(size, mid, n_rank) - a;
+      size_t nb = Slice_offset(size, hi, n_rank) - a - na;
+      // output positions [d0, d1) of the merged run
+      size_t d0 = first - a, d1 = d0 + n;
+      TRACE_BEGIN(t_co_rank)
+      size_t i0 = path_co_rank(d0, a, na, nb, size, n_rank, win);
+      size_t i1 = path_co_rank(d1, a, na, nb, size, n_rank, win);
+      size_t j0 = d0 - i0, j1 = d1 - i1;
+      TRACE_END(t_co_rank, "co_rank", level, 0);
+
+      TRACE_BEGIN(t_get)
+      path_get(pieces, a + i0, a + i1, size, n_rank, win);
+      path_get(pieces + (i1 - i0), a + na + j0, a + na + j1, size, n_rank, win);
+      MPI_Win_flush_all(win);
+      TRACE_END(t_get, "get", level, n * sizeof(DATATYPE));
+      TRACE_BEGIN(t_merge)
+      Merge(pieces, i1 - i0, pieces + (i1 - i0), j1 - j0, C);
+      TRACE_END(t_merge, "merge", level, n * sizeof(DATATYPE));
+      tmp = A; A = C; C = tmp;
+    }
+
+    TRACE_BEGIN(t_sync)
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win); // collective: the level is over for every process
+    TRACE_END(t_sync, "sync", level, 0);
+  }
+
+  *local_array = A;
+  free(C);
+  free(pieces);
 }
 
+// number of keys of A[0..na) not greater than x (they precede x in the merge)
+static size_t not_greater(const DATATYPE* A, size_t na, DATATYPE x){
+  size_t lo = 0, hi = na;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (x < A[mid])
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+/**
+ * @brief Merge the sorted list A with a sorted list of nb elements
+ * received from partner in chunks. A ring of PIPELINE_DEPTH receive buffers
+ * is kept posted: every chunk is merged as soon as it arrives, with the
+ * prefix of A it precedes (see merge_simd), and its buffer is reposted for a
+ * following chunk. Return result in C.
+ * 
+ * @param A the local sorted list
+ * @param na the size of A
+ * @param C output array for the merged list (na + nb elements)
+ * @param nb the size of the list to be received
+ * @param chunk number of elements in each message
+ * @param partner the process sending the list
+ * @param comm the communicator
+ */
+void Merge_stream(DATATYPE* A, size_t na, DATATYPE* C, size_t nb, size_t chunk, int partner, MPI_Comm comm) {
+  size_t n_chunks = (nb + chunk - 1) / chunk;
+  size_t depth = (n_chunks < PIPELINE_DEPTH) ? n_chunks : PIPELINE_DEPTH;
+  size_t ai = 0, ci = 0, c;
+  DATATYPE* ring = malloc((depth > 0 ? depth * chunk : 1) * sizeof(DATATYPE));
+  MPI_Request reqs[PIPELINE_DEPTH];
+
+  for (c = 0; c < depth; c++) {
+    size_t len = (c == n_chunks - 1) ? nb - c * chunk : chunk;
+    MPI_Irecv(ring + c * chunk, (int) len, MPITYPE, partner, 0, comm, &reqs[c]);
+  }
+
+  for (c = 0; c < n_chunks; c++) {
+    size_t slot = c % depth;
+    size_t blen = (c == n_chunks - 1) ? nb - c * chunk : chunk;
+    DATATYPE* B = ring + slot * chunk;
+
+    TRACE_BEGIN(t_wait)
+    MPI_Wait(&reqs[slot], MPI_STATUS_IGNORE);
+    TRACE_END(t_wait, "wait", -1, blen * sizeof(DATATYPE));
+
+    // the keys of A up to the last key of the chunk come before the rest of both lists
+    size_t take = not_greater(A + ai, na - ai, B[blen - 1]);
+    merge_simd(A + ai, take, B, blen, C + ci);
+    ai += take;
+    ci += take + blen;
+
+    if (c + depth < n_chunks) { // reuse the buffer for a following chunk
+      size_t next = c + depth;
+      size_t len = (next == n_chunks - 1) ? nb - next * chunk : chunk;
+      MPI_Irecv(B, (int) len, MPITYPE, partner, 0, comm, &reqs[slot]);
+    }
+  }
+  memcpy(C + ci, A + ai, (na - ai) * sizeof(DATATYPE)); // finish up A
+  free(ring);
+} 
+
 /**
- * @brief Compare 2 DATATYPES, return -1, 0, or 1,
- *  respectively, when  the first element is 
- * less than, equal, or greater than
- * the second.
+ * @brief Merge two sorted lists, A and B. Return result in C.
+ * C has na + nb elements.
+ * The merge kernel is selected for the CPU (see merge_simd).
  * 
- * @param a_p first element to compare
- * @param b_p second element to compare
- * @return int result of the compare
+ * @param A first input array
+ * @param na dimen of A
+ * @param B second input array
+ * @param nb dimen of B
+ * @param C output array for the merged list
  */
-int compare(const void* a_p, const void* b_p) {
-  int a = * ((DATATYPE* ) a_p);
-  int b = * ((DATATYPE* ) b_p);
-
-  if (a < b)
-    return -1;
-  else if (a == b)
-    return 0;
-  else /* a > b */
-    return 1;
-}
\ No newline at end of file
+void Merge(DATATYPE* A, size_t na, DATATYPE* B, size_t nb, DATATYPE* C) {
+  merge_simd(A, na, B, nb, C);
+} 
@@ -36,45 +36,73 @@
  */
 #include "../include/mergesort_serial.h"
 #include "../include/utils.h"
+#include "../include/mapfile.h"
 
-int main(int argc, char const *argv[]){
+int sort_main(int argc, char* argv[]){
 
-   if (argc < 3){
-      fprintf(stderr,"Usage: %s [filename] [input_size] [testMode (default = 0)]\n",argv[0]);
+   int n_pos = count_positional(argc, argv);
+   if (n_pos < 3){
+      fprintf(stderr,"Usage: %s [filename] [input_size] [testMode (default = 0)] [--output=output_filename] [--threads=number of threads (default = 1)]"
+                     " [--kernel=merge kernel scalar,sse4,avx2,avx512 (default = auto)] [--dtype=key type int32,int64,uint64,float,double (default = int32)]"
+                     " [--mmap (map the input and sort it straight from the page cache)]\n",argv[0]);
       exit(EXIT_FAILURE);
    }
 
-   char* filename = (char*) argv[1];
-   int size = check_int_input(argv[2]);
-   int testMode = (argc == 4) ? check_int_input(argv[3]) : 0;
+   char* filename = argv[1];
+   size_t size = check_size_input(argv[2], sizeof(DATATYPE));
+   int testMode = (n_pos == 4) ? check_int_input(argv[3]) : 0;
+   const char* out_filename = get_opt(argc, argv, "output");
+   const char* threads = get_opt(argc, argv, "threads");
+   int n_threads = (threads != NULL) ? check_int_input(threads) : 1;
+   merge_kernel_select(get_opt(argc, argv, "kernel"));
+   int use_mmap = (get_opt(argc, argv, "mmap") != NULL);
 
-   if (testMode) printf("args: %s %d %d\n",filename, size, testMode);
+   if (testMode) printf("args: %s %zu %d (merge kernel: %s)\n",filename, size, testMode, merge_kernel_name());
     
    DATATYPE *input = malloc(size * sizeof(DATATYPE));
+   const DATATYPE *unsorted = input; // the mapped file with --mmap
+   Mapped_file map;
 
    double read_timer = 0;
    double read_merge = 0;
    int return_status;
     
    START_T(read_timer);
-      return_status =  read_file(filename, input, size);
+      if (use_mmap){
+         return_status = (Map_file(filename, 0, size * sizeof(DATATYPE), &map) == 0) ? 1 : -1;
+         unsorted = map.data;
+      }else
+         return_status =  read_file(filename, input, size);
    STOP_T(read_timer);
 
-   if (testMode){
+   if (testMode && return_status > 0){
       printf(">> PRIMA\n");
-      printArray(input, size);
+      printArray((DATATYPE*) unsorted, size);
    }
 
-   if(return_status){
+   if(return_status > 0){
       START_T(read_merge);
-         mergesort_rec(input, size);
+         mergesort_par_from(unsorted, input, size, n_threads); // out-of-place from the mapping
       STOP_T(read_merge);
+      if (use_mmap)
+         Unmap_file(&map);
       
       if (testMode){
          printf(">> DOPO\n");
          printArray(input, size);
       }
-      printf("%d;0;%lf;%lf",size,read_timer,read_merge);
+      printf("%zu;0;%lf;%lf",size,read_timer,read_merge);
+
+      if (out_filename != NULL){
+         double write_timer = 0;
+         START_T(write_timer);
+            return_status = write_file(out_filename, input, size);
+         STOP_T(write_timer);
+
+         if (return_status < 0)
+            fprintf(stderr,"can't write %s", out_filename);
+         printf(";%lf",write_timer);
+      }
    }else{
       fprintf(stderr,"can't read %s", argv[1]);
    }
@@ -84,15 +112,15 @@ int main(int argc, char const *argv[]){
    return EXIT_SUCCESS;
 }
 
-void printArray(DATATYPE *array, int arraySize){
+void printArray(DATATYPE *array, size_t arraySize){
    printf("\n");
-   for (int i=0; i<arraySize; i++){
-      printf("%.3lf ", (double) array[i]);
+   for (size_t i=0; i<arraySize; i++){
+      printf(DATATYPE_FMT " ", array[i]);
    }
    printf("\n");
 }
 
-int read_file(char* filename, DATATYPE* array, int arraySize){
+int read_file(char* filename, DATATYPE* array, size_t arraySize){
    FILE* fp;
 
    if(filename != NULL){
@@ -112,4 +140,22 @@ int read_file(char* filename, DATATYPE* array, int arraySize){
       }
    }
    return -1; //failed to execute
+}
+
+int write_file(const char* filename, DATATYPE* array, size_t arraySize){
+   FILE* fp;
+
+   if(filename != NULL && array != NULL){
+      fp = fopen(filename,"wb");
+      if(fp != NULL){ //successfully opened the file
+         size_t ret = fwrite(array, sizeof(DATATYPE), arraySize, fp);
+         fclose(fp); //close the file!
+         if(ret != arraySize){ // elements written not equal to size of the buffer
+            fprintf(stderr,"written less elements than expected");
+            return -1; // FAIL
+         }
+         return 1; //success 
+      }
+   }
+   return -1; //failed to execute
 }
\ No newline at end of file
@@ -0,0 +1,332 @@
+/**
+ * @file pdqsort.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Pattern-defeating quicksort on DATATYPE
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/pdqsort.h"
+#include <stdbool.h>
+
+static inline void swap(DATATYPE* a, DATATYPE* b){
+  DATATYPE t = *a;
+  *a = *b;
+  *b = t;
+}
+
+// branchless: *a <= *b afterwards
+static inline void sort2(DATATYPE* a, DATATYPE* b){
+  DATATYPE x = *a, y = *b;
+  bool s = y < x;
+  *a = s ? y : x;
+  *b = s ? x : y;
+}
+
+static inline void sort3(DATATYPE* a, DATATYPE* b, DATATYPE* c){
+  sort2(a, b);
+  sort2(b, c);
+  sort2(a, b);
+}
+
+static void insertion_sort(DATATYPE* begin, DATATYPE* end){
+  if (begin == end) return;
+
+  for (DATATYPE* cur = begin + 1; cur != end; ++cur) {
+    DATATYPE *sift = cur, *sift_1 = cur - 1;
+    if (*sift < *sift_1) {
+      DATATYPE tmp = *sift;
+      do { *sift-- = *sift_1; } while (sift != begin && tmp < *--sift_1);
+      *sift = tmp;
+    }
+  }
+}
+
+// insertion sort of a range preceded by an element not greater than any of it (no bound check)
+static void unguarded_insertion_sort(DATATYPE* begin, DATATYPE* end){
+  if (begin == end) return;
+
+  for (DATATYPE* cur = begin + 1; cur != end; ++cur) {
+    DATATYPE *sift = cur, *sift_1 = cur - 1;
+    if (*sift < *sift_1) {
+      DATATYPE tmp = *sift;
+      do { *sift-- = *sift_1; } while (tmp < *--sift_1);
+      *sift = tmp;
+    }
+  }
+}
+
+// insertion sort giving up (false) after PDQ_PARTIAL_INSERTION_LIMIT moves
+static bool partial_insertion_sort(DATATYPE* begin, DATATYPE* end){
+  size_t limit = 0;
+
+  if (begin == end) return true;
+
+  for (DATATYPE* cur = begin + 1; cur != end; ++cur) {
+    if (limit > PDQ_PARTIAL_INSERTION_LIMIT) return false;
+
+    DATATYPE *sift = cur, *sift_1 = cur - 1;
+    if (*sift < *sift_1) {
+      DATATYPE tmp = *sift;
+      do { *sift-- = *sift_1; } while (sift != begin && tmp < *--sift_1);
+      *sift = tmp;
+      limit += cur - sift;
+    }
+  }
+  return true;
+}
+
+static void heap_sift(DATATYPE* X, size_t n, size_t i){
+  DATATYPE v = X[i];
+  for (;;) {
+    size_t c = 2 * i + 1;
+    if (c >= n) break;
+    if (c + 1 < n && X[c] < X[c + 1]) c++;
+    if (!(v < X[c])) break;
+    X[i] = X[c];
+    i = c;
+  }
+  X[i] = v;
+}
+
+// fallback after too many unbalanced partitions: O(n log n) worst case
+static void heap_sort(DATATYPE* begin, DATATYPE* end){
+  size_t n = end - begin;
+
+  for (size_t i = n / 2; i-- > 0;)
+    heap_sift(begin, n, i);
+  for (size_t i = n; i-- > 1;) {
+    swap(begin, begin + i);
+    heap_sift(begin, i, 0);
+  }
+}
+
+/*
+ * Swap the num elements misplaced on the left (offsets_l from first) with the
+ * ones misplaced on the right (offsets_r back from last). With different
+ * counts a cyclic permutation halves the moves of the swaps.
+ */
+static inline void swap_offsets(DATATYPE* first, DATATYPE* last,
+                                const unsigned char* offsets_l, const unsigned char* offsets_r,
+                                size_t num, bool use_swaps){
+  if (use_swaps) {
+    for (size_t i = 0; i < num; ++i)
+      swap(first + offsets_l[i], last - offsets_r[i]);
+  } else if (num > 0) {
+    DATATYPE *l = first + offsets_l[0], *r = last - offsets_r[0];
+    DATATYPE tmp = *l;
+    *l = *r;
+    for (size_t i = 1; i < num; ++i) {
+      l = first + offsets_l[i]; *r = *l;
+      r = last - offsets_r[i]; *l = *r;
+    }
+    *r = tmp;
+  }
+}
+
+/*
+ * Partition [begin, end) around the pivot *begin in (< pivot, >= pivot), the
+ * pivot ending between them (its position is returned). Blocks of elements
+ * are classified storing the offsets of the misplaced ones without branches,
+ * then these are swapped. already_partitioned is set when no swap was needed.
+ */
+static DATATYPE* partition_right_branchless(DATATYPE* begin, DATATYPE* end, bool* already_partitioned){
+  DATATYPE pivot = *begin;
+  DATATYPE *first = begin, *last = end;
+
+  // the median of 3 guarantees an element >= pivot, so the first scan is unguarded
+  while (*++first < pivot);
+
+  if (first - 1 == begin) while (first < last && !(*--last < pivot));
+  else                    while (!(*--last < pivot));
+
+  *already_partitioned = first >= last;
+  if (!*already_partitioned) {
+    unsigned char offsets_l[PDQ_BLOCK_SIZE], offsets_r[PDQ_BLOCK_SIZE];
+    DATATYPE *offsets_l_base, *offsets_r_base;
+    size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+    swap(first, last);
+    ++first;
+    offsets_l_base = first;
+    offsets_r_base = last;
+
+    while (first < last) {
+      size_t num_unknown = last - first;
+      size_t left_split = (num_l == 0) ? ((num_r == 0) ? num_unknown / 2 : num_unknown) : 0;
+      size_t right_split = (num_r == 0) ? num_unknown - left_split : 0;
+
+      if (left_split > PDQ_BLOCK_SIZE) left_split = PDQ_BLOCK_SIZE;
+      if (right_split > PDQ_BLOCK_SIZE) right_split = PDQ_BLOCK_SIZE;
+
+      for (size_t i = 0; i < left_split; ++i) {
+        offsets_l[num_l] = i;
+        num_l += !(*first < pivot);
+        ++first;
+      }
+      for (size_t i = 0; i < right_split;) {
+        offsets_r[num_r] = ++i;
+        num_r += *--last < pivot;
+      }
+
+      size_t num = (num_l < num_r) ? num_l : num_r;
+      swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r,
+                   num, num_l == num_r);
+      num_l -= num; num_r -= num;
+      start_l += num; start_r += num;
+
+      if (num_l == 0) {
+        start_l = 0;
+        offsets_l_base = first;
+      }
+      if (num_r == 0) {
+        start_r = 0;
+        offsets_r_base = last;
+      }
+    }
+
+    // at most one side has misplaced elements left: move them to the boundary
+    if (num_l) {
+      while (num_l--) swap(offsets_l_base + offsets_l[start_l + num_l], --last);
+      first = last;
+    }
+    if (num_r) {
+      while (num_r--) swap(offsets_r_base - offsets_r[start_r + num_r], first), ++first;
+      last = first;
+    }
+  }
+
+  DATATYPE* pivot_pos = first - 1;
+  *begin = *pivot_pos;
+  *pivot_pos = pivot;
+  return pivot_pos;
+}
+
+/*
+ * Partition [begin, end) around the pivot *begin in (== pivot, > pivot), used
+ * when the pivot equals the element before the range, i.e. no element of the
+ * range is smaller: all the keys equal to the pivot are put in place at once.
+ */
+static DATATYPE* partition_left(DATATYPE* begin, DATATYPE* end){
+  DATATYPE pivot = *begin;
+  DATATYPE *first = begin, *last = end;
+
+  while (pivot < *--last);
+
+  if (last + 1 == end) while (first < last && !(pivot < *++first));
+  else                 while (!(pivot < *++first));
+
+  while (first < last) {
+    swap(first, last);
+    while (pivot < *--last);
+    while (!(pivot < *++first));
+  }
+
+  *begin = *last;
+  *last = pivot;
+  return last;
+}
+
+// swap some elements of the range to break the pattern behind an unbalanced partition
+static void break_patterns(DATATYPE* begin, DATATYPE* end){
+  size_t size = end - begin;
+
+  if (size < PDQ_INSERTION_THRESHOLD) return;
+  swap(begin, begin + size / 4);
+  swap(end - 1, end - size / 4);
+  if (size > PDQ_NINTHER_THRESHOLD) {
+    swap(begin + 1, begin + (size / 4 + 1));
+    swap(begin + 2, begin + (size / 4 + 2));
+    swap(end - 2, end - (size / 4 + 1));
+    swap(end - 3, end - (size / 4 + 2));
+  }
+}
+
+static void pdq_loop(DATATYPE* begin, DATATYPE* end, int bad_allowed, bool leftmost){
+  for (;;) {
+    size_t size = end - begin;
+    size_t s2 = size / 2;
+
+    if (size < PDQ_INSERTION_THRESHOLD) {
+      if (leftmost) insertion_sort(begin, end);
+      else unguarded_insertion_sort(begin, end);
+      return;
+    }
+
+    // pivot to *begin
+    if (size > PDQ_NINTHER_THRESHOLD) {
+      sort3(begin, begin + s2, end - 1);
+      sort3(begin + 1, begin + (s2 - 1), end - 2);
+      sort3(begin + 2, begin + (s2 + 1), end - 3);
+      sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+      swap(begin, begin + s2);
+    } else {
+      sort3(begin + s2, begin, end - 1);
+    }
+
+    // the pivot equals the previous pivot: take the equal keys away and go on with the rest
+    if (!leftmost && !(*(begin - 1) < *begin)) {
+      begin = partition_left(begin, end) + 1;
+      continue;
+    }
+
+    bool already_partitioned;
+    DATATYPE* pivot_pos = partition_right_branchless(begin, end, &already_partitioned);
+    size_t l_size = pivot_pos - begin;
+    size_t r_size = end - (pivot_pos + 1);
+
+    if (l_size < size / 8 || r_size < size / 8) { // highly unbalanced
+      if (--bad_allowed == 0) {
+        heap_sort(begin, end);
+        return;
+      }
+      break_patterns(begin, pivot_pos);
+      break_patterns(pivot_pos + 1, end);
+    } else if (already_partitioned && partial_insertion_sort(begin, pivot_pos)
+                                   && partial_insertion_sort(pivot_pos + 1, end)) {
+      return; // (nearly) sorted input
+    }
+
+    // recursion on the left part, loop on the right one
+    pdq_loop(begin, pivot_pos, bad_allowed, leftmost);
+    begin = pivot_pos + 1;
+    leftmost = false;
+  }
+}
+
+void pdq_sort(DATATYPE* X, size_t n){
+  int log2n = 0;
+
+  if (n < 2) return;
+  while ((n >> log2n) > 1) log2n++;
+  pdq_loop(X, X + n, log2n, true);
+}
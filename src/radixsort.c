@@ -0,0 +1,198 @@
+/**
+ * @file radixsort.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Radix sort (MSD split, then LSD in cache) with order-preserving key transforms
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/radixsort.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// kind of key: floating point, signed or unsigned integer
+#define KEY_IS_FLOAT _Generic((DATATYPE)0, float: 1, double: 1, long double: 1, default: 0)
+#define KEY_IS_SIGNED _Generic((DATATYPE)0, unsigned char: 0, unsigned short: 0, unsigned int: 0, \
+                              unsigned long: 0, unsigned long long: 0, default: 1)
+
+/*
+ * Radix sort on the unsigned integer U with the same size of DATATYPE.
+ * The key transform is applied while the histograms are computed and
+ * by the first scatter, and reverted in the last pass over each bucket.
+ */
+#define DEFINE_RADIX_SORT(NAME, U)                                                  \
+static inline U NAME##_to_key(U u){                                                 \
+  const U sign = (U)1 << (sizeof(U) * 8 - 1);                                       \
+  if (KEY_IS_FLOAT)                                                                 \
+    return (u & sign) ? (U)~u : (U)(u ^ sign);                                      \
+  return KEY_IS_SIGNED ? (U)(u ^ sign) : u;                                         \
+}                                                                                   \
+                                                                                    \
+static inline U NAME##_from_key(U u){                                               \
+  const U sign = (U)1 << (sizeof(U) * 8 - 1);                                       \
+  if (KEY_IS_FLOAT)                                                                 \
+    return (u & sign) ? (U)(u ^ sign) : (U)~u;                                      \
+  return KEY_IS_SIGNED ? (U)(u ^ sign) : u;                                         \
+}                                                                                   \
+                                                                                    \
+/* LSD passes on the digits below msd of the m keys of a bucket, */                 \
+/* alternating between the bucket in tmp and in X, result in X */                   \
+static void NAME##_bucket(U* t, U* x, size_t m, int msd, int bits,                  \
+                          const int* trivial, size_t* h){                           \
+  const size_t n_buckets = (size_t)1 << bits;                                       \
+  const U mask = (U)(n_buckets - 1);                                                \
+  U *src = t, *dst = x;                                                             \
+                                                                                    \
+  if (m <= RADIX_SMALL) { /* insertion sort */                                      \
+    for (size_t i = 1; i < m; i++) {                                                \
+      U k = t[i];                                                                   \
+      size_t j = i;                                                                 \
+      for (; j > 0 && k < t[j - 1]; j--)                                            \
+        t[j] = t[j - 1];                                                            \
+      t[j] = k;                                                                     \
+    }                                                                               \
+  } else {                                                                          \
+    for (int p = 0; p < msd; p++) {                                                 \
+      int shift = p * bits;                                                         \
+      size_t sum = 0;                                                               \
+                                                                                    \
+      if (trivial[p]) /* same digit for every key of the array */                   \
+        continue;                                                                   \
+      memset(h, 0, n_buckets * sizeof(size_t));                                     \
+      for (size_t i = 0; i < m; i++)                                                \
+        h[(src[i] >> shift) & mask]++;                                              \
+      if (h[(src[0] >> shift) & mask] == m) /* same digit in the bucket */          \
+        continue;                                                                   \
+      for (size_t b = 0; b < n_buckets; b++) { /* histogram -> offsets */           \
+        size_t c = h[b];                                                            \
+        h[b] = sum;                                                                 \
+        sum += c;                                                                   \
+      }                                                                             \
+      for (size_t i = 0; i < m; i++) {                                              \
+        U k = src[i];                                                               \
+        dst[h[(k >> shift) & mask]++] = k;                                          \
+      }                                                                             \
+      U* s = src; src = dst; dst = s;                                               \
+    }                                                                               \
+  }                                                                                 \
+  /* revert the transform (in place if the last pass ended in x) */                 \
+  for (size_t i = 0; i < m; i++)                                                    \
+    x[i] = NAME##_from_key(src[i]);                                                 \
+}                                                                                   \
+                                                                                    \
+static void NAME(const U* in, U* X, size_t n){                                      \
+  const int key_bits = sizeof(U) * 8;                                               \
+  const int bits = (key_bits >= 32) ? RADIX_BITS : 8;                               \
+  const int n_passes = (key_bits + bits - 1) / bits;                                \
+  const size_t n_buckets = (size_t)1 << bits;                                       \
+  const U mask = (U)(n_buckets - 1);                                                \
+  size_t* hist = calloc((size_t) n_passes * n_buckets, sizeof(size_t));             \
+  size_t* start = malloc((n_buckets + 1) * sizeof(size_t));                         \
+  int* trivial = malloc(n_passes * sizeof(int));                                    \
+  int p, msd = -1;                                                                  \
+                                                                                    \
+  /* all the histograms of the transformed keys in one read pass */                 \
+  for (size_t i = 0; i < n; i++) {                                                  \
+    U k = NAME##_to_key(in[i]);                                                     \
+    for (p = 0; p < n_passes; p++)                                                  \
+      hist[p * n_buckets + ((k >> (p * bits)) & mask)]++;                           \
+  }                                                                                 \
+  /* the passes whose digit is the same for every key are skipped */                \
+  for (p = 0; p < n_passes; p++) {                                                  \
+    U k0 = NAME##_to_key(in[0]);                                                    \
+    trivial[p] = (hist[p * n_buckets + ((k0 >> (p * bits)) & mask)] == n);          \
+    if (!trivial[p])                                                                \
+      msd = p;                                                                      \
+  }                                                                                 \
+                                                                                    \
+  if (msd < 0) { /* all the keys are equal */                                       \
+    if (in != X)                                                                    \
+      memcpy(X, in, n * sizeof(U));                                                 \
+  } else {                                                                          \
+    /* MSD scatter on the most significant digit that is not the same */            \
+    /* for every key: each bucket is then sorted on the lower digits */             \
+    /* while it is in cache, instead of a pass over the array per digit */          \
+    U* tmp = malloc(n * sizeof(U));                                                 \
+    size_t* h = hist + msd * n_buckets;                                             \
+    size_t sum = 0;                                                                 \
+    int shift = msd * bits;                                                         \
+                                                                                    \
+    for (size_t b = 0; b < n_buckets; b++) {                                        \
+      size_t c = h[b];                                                              \
+      start[b] = h[b] = sum;                                                        \
+      sum += c;                                                                     \
+    }                                                                               \
+    start[n_buckets] = n;                                                           \
+    for (size_t i = 0; i < n; i++) {                                                \
+      U k = NAME##_to_key(in[i]);                                                   \
+      tmp[h[(k >> shift) & mask]++] = k;                                            \
+    }                                                                               \
+    for (size_t b = 0; b < n_buckets; b++)                                          \
+      NAME##_bucket(tmp + start[b], X + start[b], start[b + 1] - start[b],          \
+                    msd, bits, trivial, hist);                                      \
+    free(tmp);                                                                      \
+  }                                                                                 \
+                                                                                    \
+  free(trivial);                                                                    \
+  free(start);                                                                      \
+  free(hist);                                                                       \
+}
+
+DEFINE_RADIX_SORT(radix_sort_8bit, uint8_t)
+DEFINE_RADIX_SORT(radix_sort_16bit, uint16_t)
+DEFINE_RADIX_SORT(radix_sort_32bit, uint32_t)
+DEFINE_RADIX_SORT(radix_sort_64bit, uint64_t)
+
+void radix_sort(DATATYPE* X, size_t n){
+  radix_sort_from(X, X, n);
+}
+
+void radix_sort_from(const DATATYPE* in, DATATYPE* X, size_t n){
+  if (n < 2) {
+    if (n == 1 && in != X)
+      X[0] = in[0];
+    return;
+  }
+
+  // the keys are sorted by their bit pattern, as unsigned integers of the same size
+  switch (sizeof(DATATYPE)) {
+    case 1: radix_sort_8bit((const uint8_t*) in, (uint8_t*) X, n); break;
+    case 2: radix_sort_16bit((const uint16_t*) in, (uint16_t*) X, n); break;
+    case 4: radix_sort_32bit((const uint32_t*) in, (uint32_t*) X, n); break;
+    case 8: radix_sort_64bit((const uint64_t*) in, (uint64_t*) X, n); break;
+    default:
+      fprintf(stderr,"radix sort: unsupported key size\n");
+      exit(EXIT_FAILURE);
+  }
+}
@@ -0,0 +1,274 @@
+/**
+ * @file recordMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Parallel sort of key + payload records
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/recordMPI.h"
+#include <stddef.h>
+#include <string.h>
+
+// the key of a record (records have no alignment)
+static inline DATATYPE key_of(const char* record, size_t key_offset){
+  DATATYPE key;
+  memcpy(&key, record + key_offset, sizeof(DATATYPE));
+  return key;
+}
+
+void Merge_records(const char* A, size_t na, const char* B, size_t nb, char* out, size_t rec_size, size_t key_offset){
+  const char *a_end = A + na * rec_size, *b_end = B + nb * rec_size;
+
+  while (A < a_end && B < b_end) {
+    if (key_of(B, key_offset) < key_of(A, key_offset)) {
+      memcpy(out, B, rec_size);
+      B += rec_size;
+    } else {
+      memcpy(out, A, rec_size);
+      A += rec_size;
+    }
+    out += rec_size;
+  }
+  memcpy(out, A, a_end - A);
+  memcpy(out + (a_end - A), B, b_end - B);
+}
+
+/**
+ * @brief Insertion sort of n records, tmp holds one record.
+ */
+static void insertion_sort_records(char* X, size_t n, size_t rec_size, size_t key_offset, char* tmp){
+  for (size_t i = 1; i < n; i++) {
+    DATATYPE key = key_of(X + i * rec_size, key_offset);
+    size_t j = i;
+    while (j > 0 && key < key_of(X + (j-1) * rec_size, key_offset))
+      j--;
+    if (j < i) {
+      memcpy(tmp, X + i * rec_size, rec_size);
+      memmove(X + (j+1) * rec_size, X + j * rec_size, (i - j) * rec_size);
+      memcpy(X + j * rec_size, tmp, rec_size);
+    }
+  }
+}
+
+/**
+ * @brief Stable bottom-up merge sort of n records: runs of RECORD_RUN records
+ * are sorted by insertion sort, then merged alternating X and tmp (n records).
+ */
+static void sort_records(char* X, size_t n, size_t rec_size, size_t key_offset, char* tmp){
+  char *src = X, *dst = tmp, *t;
+
+  for (size_t lo = 0; lo < n; lo += RECORD_RUN)
+    insertion_sort_records(X + lo * rec_size, (n - lo > RECORD_RUN) ? RECORD_RUN : n - lo, rec_size, key_offset, tmp);
+
+  for (size_t w = RECORD_RUN; w < n; w *= 2) {
+    for (size_t lo = 0; lo < n; lo += 2 * w) {
+      size_t mid = (n - lo > w) ? lo + w : n;
+      size_t hi = (n - mid > w) ? mid + w : n;
+      Merge_records(src + lo * rec_size, mid - lo, src + mid * rec_size, hi - mid, dst + lo * rec_size, rec_size, key_offset);
+    }
+    t = src; src = dst; dst = t;
+  }
+  if (src != X)
+    memcpy(X, src, n * rec_size);
+}
+
+/**
+ * @brief The (key, first + i) pairs of the n records, sorted by key,
+ * in a buffer of cap pairs.
+ */
+static Key_index* sort_keys(const char* records, size_t n, size_t cap, size_t rec_size, size_t key_offset,
+                            size_t first){
+  Key_index* pairs = malloc((cap > 0 ? cap : 1) * sizeof(Key_index));
+  Key_index* tmp = malloc((n > 0 ? n : 1) * sizeof(Key_index));
+  for (size_t i = 0; i < n; i++) {
+    pairs[i].key = key_of(records + i * rec_size, key_offset);
+    pairs[i].index = first + i;
+  }
+  sort_records((char*) pairs, n, sizeof(Key_index), offsetof(Key_index, key), (char*) tmp);
+  free(tmp);
+  return pairs;
+}
+
+/**
+ * @brief Record i of the result is the record pairs[i].index: each record is
+ * moved once along the cycles of the permutation (done positions get index = i).
+ */
+static void permute_records(char* records, Key_index* pairs, size_t n, size_t rec_size){
+  char* hold = malloc(rec_size);
+  for (size_t i = 0; i < n; i++) {
+    if (pairs[i].index == i)
+      continue;
+    size_t j = i, k;
+    memcpy(hold, records + i * rec_size, rec_size);
+    for (;;) {
+      k = pairs[j].index;
+      pairs[j].index = j;
+      if (k == i)
+        break;
+      memcpy(records + j * rec_size, records + k * rec_size, rec_size);
+      j = k;
+    }
+    memcpy(records + j * rec_size, hold, rec_size);
+  }
+  free(hold);
+}
+
+void Record_local_sort(char* records, size_t n, size_t rec_size, size_t key_offset, int strategy){
+  if (strategy == RECORD_SORT_AUTO)
+    strategy = (rec_size <= RECORD_DIRECT_MAX) ? RECORD_SORT_DIRECT : RECORD_SORT_INDEX;
+
+  if (strategy == RECORD_SORT_DIRECT) {
+    char* tmp = malloc((n > 0 ? n : 1) * rec_size);
+    sort_records(records, n, rec_size, key_offset, tmp);
+    free(tmp);
+    return;
+  }
+
+  // sort the (key, index) pairs: the payload does not move
+  Key_index* pairs = sort_keys(records, n, n, rec_size, key_offset, 0);
+  permute_records(records, pairs, n, rec_size);
+  free(pairs);
+}
+
+void Record_merge_sort(char** local_records, size_t size, size_t rec_size, size_t key_offset,
+                       MPI_Datatype rec_type, int rank, int n_rank, MPI_Comm comm) {
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+  size_t n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t cap = Merge_buffer_size(size, rank, n_rank);
+  char *A = *local_records, *C = NULL, *tmp;
+
+  if (tree.n_children > 0) // leaves only send: no second buffer
+    C = malloc(cap * rec_size);
+
+  for (int k = 0; k < tree.n_children; k++) { // process receive from its children
+    size_t nb = Slice_offset(size, tree.child_end[k], n_rank) - Slice_offset(size, tree.child[k], n_rank);
+    TRACE_BEGIN(t_recv)
+    Recv_large(A + n * rec_size, nb, rec_type, tree.child[k], 0, comm);
+    TRACE_END(t_recv, "recv", k, nb * rec_size);
+    TRACE_BEGIN(t_merge)
+    Merge_records(A, n, A + n * rec_size, nb, C, rec_size, key_offset);
+    TRACE_END(t_merge, "merge", k, (n + nb) * rec_size);
+    tmp = A; A = C; C = tmp;
+    n += nb;
+  }
+  if (tree.parent >= 0) { // process send to its parent
+    TRACE_BEGIN(t_send)
+    Send_large(A, n, rec_type, tree.parent, 0, comm);
+    TRACE_END(t_send, "send", tree.n_children, n * rec_size);
+  }
+
+  *local_records = A;
+  free(C);
+}
+
+void Record_index_merge_sort(Key_index** pairs, char* records, size_t size, size_t rec_size,
+                             MPI_Datatype rec_type, int rank, int n_rank, MPI_Comm comm) {
+  MPI_Datatype pair_type;
+
+  // the tree merge of the records, on the pairs
+  MPI_Type_contiguous((int) sizeof(Key_index), MPI_BYTE, &pair_type);
+  MPI_Type_commit(&pair_type);
+  Record_merge_sort((char**) pairs, size, sizeof(Key_index), offsetof(Key_index, key), pair_type, rank, n_rank, comm);
+  MPI_Type_free(&pair_type);
+
+  // the records reach rank 0 once, in input order, and are moved there to their place
+  TRACE_BEGIN(t_gather)
+  if (rank == 0) {
+    for (int i = 1; i < n_rank; i++) {
+      size_t first = Slice_offset(size, i, n_rank);
+      Recv_large(records + first * rec_size, Slice_offset(size, i + 1, n_rank) - first, rec_type, i, 1, comm);
+    }
+  } else
+    Send_large(records, Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank), rec_type, 0, 1, comm);
+  TRACE_END(t_gather, "gather", -1, size * rec_size);
+
+  if (rank == 0) {
+    TRACE_BEGIN(t_permute)
+    permute_records(records, *pairs, size, rec_size);
+    TRACE_END(t_permute, "permute", -1, size * rec_size);
+  }
+}
+
+void Record_sort(char* filename, size_t size, const char* out_filename, size_t rec_size, size_t key_offset,
+                 int strategy, int version, int test_mode, int rank, int n_rank, MPI_Comm comm,
+                 double* init_time, double* local_time, double* merge_time, double* write_time) {
+  size_t local_n = Slice_offset(size, rank + 1, n_rank) - Slice_offset(size, rank, n_rank);
+  size_t cap = Merge_buffer_size(size, rank, n_rank);
+  Key_index* pairs = NULL;
+  MPI_Datatype rec_type;
+  double start, end, sum;
+
+  if (strategy == RECORD_SORT_AUTO)
+    strategy = (rec_size <= RECORD_DIRECT_MAX) ? RECORD_SORT_DIRECT : RECORD_SORT_INDEX;
+
+  MPI_Type_contiguous((int) rec_size, MPI_BYTE, &rec_type);
+  MPI_Type_commit(&rec_type);
+
+  // with the index strategy only the pairs travel the tree: a process keeps its slice, rank 0 gets all
+  size_t n_records = (strategy == RECORD_SORT_INDEX && rank != 0) ? local_n : cap;
+  char* records = malloc((n_records > 0 ? n_records : 1) * rec_size);
+
+  *init_time = Read_elements(records, size, rec_type, n_rank, rank, filename, version, comm);
+
+  START_T(start)
+  if (strategy == RECORD_SORT_INDEX)
+    pairs = sort_keys(records, local_n, cap, rec_size, key_offset, Slice_offset(size, rank, n_rank));
+  else
+    Record_local_sort(records, local_n, rec_size, key_offset, strategy);
+  END_T(end, start, comm, sum, "local_sort", local_n * rec_size)
+  *local_time = sum / n_rank;
+
+  double t_merge = MPI_Wtime();
+  if (strategy == RECORD_SORT_INDEX) {
+    Record_index_merge_sort(&pairs, records, size, rec_size, rec_type, rank, n_rank, comm);
+    free(pairs);
+  } else
+    Record_merge_sort(&records, size, rec_size, key_offset, rec_type, rank, n_rank, comm);
+  double merge_local = MPI_Wtime() - t_merge;
+  *merge_time = 0;
+  MPI_Reduce(&merge_local, merge_time, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+  if (test_mode && rank == 0) {
+    printf("\n### DOPO ###\n");
+    for (size_t i = 0; i < size; i++)
+      printf(DATATYPE_FMT " ", key_of(records + i * rec_size, key_offset));
+    printf("\n");
+  }
+
+  *write_time = 0;
+  if (out_filename != NULL) // after the tree merge all the records are on rank 0
+    *write_time = Write_elements(records, (rank == 0) ? size : 0, rec_type, n_rank, rank, out_filename, version, comm);
+
+  free(records);
+  MPI_Type_free(&rec_type);
+}
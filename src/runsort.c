@@ -0,0 +1,259 @@
+/**
+ * @file runsort.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Adaptive natural merge sort (powersort) with galloping
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/runsort.h"
+#include "../include/utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// number of elements of A[0..n) that are <= key (A sorted), searched from the start
+static size_t gallop_right(DATATYPE key, const DATATYPE* A, size_t n){
+  size_t lo = 0, hi = 1;
+
+  while (hi < n && !(key < A[hi - 1])) { // exponential search: A[hi-1] <= key
+    lo = hi;
+    hi = 2 * hi + 1;
+  }
+  if (hi > n) hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (key < A[mid]) hi = mid;
+    else lo = mid + 1;
+  }
+  return lo;
+}
+
+// number of elements of A[0..n) that are < key (A sorted), searched from the start
+static size_t gallop_left(DATATYPE key, const DATATYPE* A, size_t n){
+  size_t lo = 0, hi = 1;
+
+  while (hi < n && A[hi - 1] < key) {
+    lo = hi;
+    hi = 2 * hi + 1;
+  }
+  if (hi > n) hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (A[mid] < key) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// same as gallop_left, searched from the end of A (for the tail of the right run)
+static size_t gallop_left_back(DATATYPE key, const DATATYPE* A, size_t n){
+  size_t lo = 0, hi = 1; // the last hi elements of A are >= key
+
+  while (hi <= n && !(A[n - hi] < key)) {
+    lo = hi;
+    hi = 2 * hi + 1;
+  }
+  if (hi > n + 1) hi = n + 1;
+  // answer is n - k, with k in [lo, hi): the largest k such that A[n-k..n) >= key
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (!(A[n - mid] < key)) lo = mid;
+    else hi = mid;
+  }
+  return n - lo;
+}
+
+/**
+ * @brief Stable merge of the adjacent runs X[0..n1) and X[n1..n1+n2), tmp holds n1 elements.
+ */
+static void merge_runs(DATATYPE* X, size_t n1, size_t n2, DATATYPE* tmp){
+  DATATYPE *A = X, *B = X + n1;
+  size_t k;
+
+  if (!(B[0] < A[n1 - 1])) // already in order
+    return;
+
+  // A[0..k) <= B[0] and B[n2..) >= A[n1-1] are already in place
+  k = gallop_right(B[0], A, n1);
+  A += k; n1 -= k;
+  n2 = gallop_left_back(A[n1 - 1], B, n2);
+
+  // merge forward: the copy of A goes to tmp, the output never passes the unread part of B
+  memcpy(tmp, A, n1 * sizeof(DATATYPE));
+  const DATATYPE *a = tmp, *a_end = tmp + n1;
+  DATATYPE *b = B, *b_end = B + n2, *out = A;
+
+  while (a < a_end && b < b_end) {
+    size_t wins_a = 0, wins_b = 0;
+
+    // one element at a time, until a run wins RUN_MIN_GALLOP times in a row
+    while (a < a_end && b < b_end) {
+      if (*b < *a) {
+        *out++ = *b++;
+        wins_a = 0;
+        if (++wins_b >= RUN_MIN_GALLOP) break;
+      } else {
+        *out++ = *a++;
+        wins_b = 0;
+        if (++wins_a >= RUN_MIN_GALLOP) break;
+      }
+    }
+    if (a == a_end || b == b_end)
+      break;
+
+    // galloping: move the whole block of the winning run at once
+    if (wins_a >= RUN_MIN_GALLOP) {
+      k = gallop_right(*b, a, a_end - a);
+      memcpy(out, a, k * sizeof(DATATYPE));
+      a += k;
+    } else {
+      k = gallop_left(*a, b, b_end - b);
+      memmove(out, b, k * sizeof(DATATYPE));
+      b += k;
+    }
+    out += k;
+  }
+  memcpy(out, a, (a_end - a) * sizeof(DATATYPE)); // the rest of B is in place
+}
+
+// insertion sort of X[0..n) knowing that X[0..sorted) is sorted
+static void insertion_sort_from(DATATYPE* X, size_t sorted, size_t n){
+  for (size_t i = (sorted > 0) ? sorted : 1; i < n; i++) {
+    DATATYPE key = X[i];
+    size_t j = i;
+    while (j > 0 && key < X[j - 1]) {
+      X[j] = X[j - 1];
+      j--;
+    }
+    X[j] = key;
+  }
+}
+
+// length of the natural run starting at X[0]: ascending, or strictly descending
+// (so that reversing it is stable) when *descending is set
+static size_t run_length(const DATATYPE* X, size_t n, int* descending){
+  size_t len = 1;
+
+  *descending = 0;
+  if (n < 2) return n;
+  if (X[1] < X[0]) {
+    *descending = 1;
+    while (len < n && X[len] < X[len - 1]) len++;
+  } else
+    while (len < n && !(X[len] < X[len - 1])) len++;
+  return len;
+}
+
+// length of the natural run starting at X[0], reversed in place if descending
+static size_t natural_run(DATATYPE* X, size_t n){
+  int descending;
+  size_t len = run_length(X, n, &descending);
+
+  if (descending)
+    for (size_t i = 0, j = len - 1; i < j; i++, j--) {
+      DATATYPE t = X[i];
+      X[i] = X[j];
+      X[j] = t;
+    }
+  return len;
+}
+
+// powersort node power of the boundary between the runs [s1, s1+n1) and [s1+n1, s1+n1+n2)
+static int node_power(size_t s1, size_t n1, size_t n2, size_t n){
+  unsigned long long a = 2ULL * s1 + n1;  // 2 * n * (midpoint of run 1) / n
+  unsigned long long b = a + n1 + n2;     // 2 * n * (midpoint of run 2) / n
+  int power = 0;
+
+  for (;;) { // first bit where the binary fractions a / 2n and b / 2n differ
+    power++;
+    if (a >= n) {
+      a -= n;
+      b -= n;
+    } else if (b >= n)
+      break;
+    a <<= 1;
+    b <<= 1;
+  }
+  return power;
+}
+
+void run_sort(DATATYPE* X, size_t n){
+  size_t base[RUN_STACK], len[RUN_STACK];
+  int power[RUN_STACK], top = 0;
+  DATATYPE* tmp;
+
+  if (n < 2) return;
+
+  // no run structure to exploit (natural runs shorter than RUN_MIN on average):
+  // the branch-free merge sort is faster
+  size_t runs = 0;
+  int descending;
+  for (size_t lo = 0; lo < n; runs++)
+    lo += run_length(X + lo, n - lo, &descending);
+  if (runs > n / RUN_MIN) {
+    mergesort_rec(X, n);
+    return;
+  }
+
+  tmp = malloc(n * sizeof(DATATYPE));
+
+  for (size_t lo = 0; lo < n; ) {
+    size_t run = natural_run(X + lo, n - lo);
+    if (run < RUN_MIN) { // extend the run by insertion sort
+      size_t ext = (n - lo > RUN_MIN) ? RUN_MIN : n - lo;
+      insertion_sort_from(X + lo, run, ext);
+      run = ext;
+    }
+
+    if (top > 0) {
+      int p = node_power(base[top - 1], len[top - 1], run, n);
+      // merge the pending runs across boundaries of higher power
+      while (top > 1 && power[top - 2] > p) {
+        merge_runs(X + base[top - 2], len[top - 2], len[top - 1], tmp);
+        len[top - 2] += len[top - 1];
+        top--;
+      }
+      power[top - 1] = p; // power of the boundary after the top run
+    }
+    base[top] = lo;
+    len[top] = run;
+    top++;
+    lo += run;
+  }
+
+  while (top > 1) {
+    merge_runs(X + base[top - 2], len[top - 2], len[top - 1], tmp);
+    len[top - 2] += len[top - 1];
+    top--;
+  }
+  free(tmp);
+}
@@ -0,0 +1,206 @@
+/**
+ * @file samplesortMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Parallel sample sort with regular sampling using MPI
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/samplesortMPI.h"
+#include "../include/utils.h"
+
+/**
+ * @brief Index of the first element of the sorted array
+ * that is not lower than key (lower bound).
+ */
+static size_t lower_bound(const DATATYPE* a, size_t n, DATATYPE key){
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (a[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/**
+ * @brief Index of the first element of the sorted array
+ * that is greater than key (upper bound).
+ */
+static size_t upper_bound(const DATATYPE* a, size_t n, DATATYPE key){
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (key < a[mid])
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+int Splitter_compare(const void* a, const void* b){
+  const Splitter *x = a, *y = b;
+  if (x->key < y->key)
+    return -1;
+  if (y->key < x->key)
+    return 1;
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+size_t Splitter_bound(const DATATYPE* a, size_t n, size_t offset, Splitter s){
+  size_t lo = lower_bound(a, n, s.key), hi = upper_bound(a + lo, n - lo, s.key) + lo;
+  // the keys equal to s.key are ordered by position: the first ones up to s.index
+  size_t cut = (s.index >= offset) ? s.index - offset + 1 : 0;
+  return (cut < lo) ? lo : (cut > hi) ? hi : cut;
+}
+
+void Select_splitters(const Splitter* samples, size_t n_samples, int n_rank, Splitter* splitters, MPI_Comm comm) {
+  Splitter *regular, *all_samples;
+  int i, count, total, *counts, *displs;
+
+  regular = malloc(n_rank * sizeof(Splitter));
+  counts = malloc(n_rank * sizeof(int));
+  displs = malloc(n_rank * sizeof(int));
+
+  // regular samples of the local (sorted) ones; a process without samples gives none
+  count = (n_samples > 0) ? n_rank : 0;
+  for (i = 0; i < count; i++)
+    regular[i] = samples[i * n_samples / n_rank];
+
+  count *= (int) sizeof(Splitter);
+  MPI_Allgather(&count, 1, MPI_INT, counts, 1, MPI_INT, comm);
+  total = 0;
+  for (i = 0; i < n_rank; i++) {
+    displs[i] = total;
+    total += counts[i];
+  }
+  all_samples = malloc(total > 0 ? total : 1);
+  MPI_Allgatherv(regular, count, MPI_BYTE, all_samples, counts, displs, MPI_BYTE, comm);
+  total /= (int) sizeof(Splitter);
+  qsort(all_samples, total, sizeof(Splitter), Splitter_compare);
+
+  for (i = 1; i < n_rank; i++) {
+    if (total == 0) { // no keys at all: every bucket is empty
+      splitters[i - 1].key = 0;
+      splitters[i - 1].index = 0;
+    } else {
+      size_t at = (size_t) i * total / n_rank + total / (2 * n_rank);
+      splitters[i - 1] = all_samples[(at < (size_t) total) ? at : (size_t) total - 1];
+    }
+  }
+
+  free(regular);
+  free(all_samples);
+  free(counts);
+  free(displs);
+}
+
+size_t Sample_sort(DATATYPE** local_array, size_t local_n, int rank, int n_rank, MPI_Comm comm) {
+  DATATYPE *recv_buf, *result, **runs;
+  Splitter *splitters, *samples;
+  size_t *send_counts, *send_displs, *recv_counts, *recv_displs;
+  size_t new_n, offset = 0;
+  int i;
+
+  if (n_rank == 1)
+    return local_n;
+
+  splitters = malloc((n_rank - 1) * sizeof(Splitter));
+  samples = malloc(n_rank * sizeof(Splitter));
+  send_counts = malloc(n_rank * sizeof(size_t));
+  send_displs = malloc(n_rank * sizeof(size_t));
+  recv_counts = malloc(n_rank * sizeof(size_t));
+  recv_displs = malloc(n_rank * sizeof(size_t));
+  runs = malloc(n_rank * sizeof(DATATYPE*));
+
+  TRACE_BEGIN(t_split)
+  // the global position of the elements breaks the ties between equal keys
+  MPI_Exscan(&local_n, &offset, 1, MPI_SIZE_T, MPI_SUM, comm);
+  if (rank == 0)
+    offset = 0; // MPI_Exscan leaves it undefined on rank 0
+  for (i = 0; i < n_rank && local_n > 0; i++) {
+    size_t at = (size_t) i * local_n / n_rank;
+    samples[i].key = (*local_array)[at];
+    samples[i].index = offset + at;
+  }
+  Select_splitters(samples, (local_n > 0) ? n_rank : 0, n_rank, splitters, comm);
+
+  // bucket i holds the elements in (splitters[i-1], splitters[i]] of the (key, index) order
+  send_displs[0] = 0;
+  for (i = 0; i < n_rank - 1; i++) {
+    size_t end = Splitter_bound(*local_array, local_n, offset, splitters[i]);
+    send_counts[i] = end - send_displs[i];
+    send_displs[i + 1] = end;
+  }
+  send_counts[n_rank - 1] = local_n - send_displs[n_rank - 1];
+  TRACE_END(t_split, "splitters", -1, 0);
+
+  TRACE_BEGIN(t_exchange)
+  MPI_Alltoall(send_counts, 1, MPI_SIZE_T, recv_counts, 1, MPI_SIZE_T, comm);
+
+  new_n = 0;
+  for (i = 0; i < n_rank; i++) {
+    recv_displs[i] = new_n;
+    new_n += recv_counts[i];
+  }
+
+  recv_buf = malloc((new_n > 0 ? new_n : 1) * sizeof(DATATYPE));
+  result = malloc((new_n > 0 ? new_n : 1) * sizeof(DATATYPE));
+
+  Alltoallv_large(*local_array, send_counts, send_displs,
+                  recv_buf, recv_counts, recv_displs, MPITYPE, comm);
+  TRACE_END(t_exchange, "exchange", -1, new_n * sizeof(DATATYPE));
+
+  // each received bucket is already sorted: k-way merge them
+  for (i = 0; i < n_rank; i++)
+    runs[i] = recv_buf + recv_displs[i];
+  TRACE_BEGIN(t_merge)
+  kway_merge(runs, recv_counts, n_rank, result);
+  TRACE_END(t_merge, "merge", -1, new_n * sizeof(DATATYPE));
+
+  free(*local_array);
+  *local_array = result;
+
+  free(recv_buf);
+  free(runs);
+  free(splitters);
+  free(samples);
+  free(send_counts);
+  free(send_displs);
+  free(recv_counts);
+  free(recv_displs);
+
+  return new_n;
+}
@@ -0,0 +1,297 @@
+/**
+ * @file selectMPI.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Distributed selection of ranks, percentiles and top-k without a sort
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/selectMPI.h"
+#include "../include/pdqsort.h"
+#include "../include/simd_merge.h"
+#include "../include/args.h"
+#include <math.h>
+#include <string.h>
+
+// next pseudo random number of the stream (splitmix64)
+static inline uint64_t next_random(uint64_t* state){
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static inline void swap_keys(DATATYPE* a, DATATYPE* b){
+  DATATYPE t = *a;
+  *a = *b;
+  *b = t;
+}
+
+// append the entries of the comma separated list to k (parse gives the rank of an entry)
+static size_t parse_list(const char* list, size_t size, size_t** k, size_t n_k, size_t (*parse)(const char*, size_t)){
+  char* copy = strdup(list);
+  char* save = NULL;
+
+  for (char* entry = strtok_r(copy, ",", &save); entry != NULL; entry = strtok_r(NULL, ",", &save)) {
+    *k = realloc(*k, (n_k + 1) * sizeof(size_t));
+    (*k)[n_k++] = parse(entry, size);
+  }
+  free(copy);
+  return n_k;
+}
+
+static size_t parse_rank(const char* entry, size_t size){
+  size_t k = check_size_input(entry, 1);
+  if (k >= size) {
+    fprintf(stderr, "rank %zu out of the %zu keys\n", k, size);
+    exit(EXIT_FAILURE);
+  }
+  return k;
+}
+
+// nearest rank: the smallest key with at least p% of the keys not greater than it
+static size_t parse_percentile(const char* entry, size_t size){
+  char* end;
+  double p = strtod(entry, &end);
+  if (end == entry || *end != '\0' || !(p >= 0 && p <= 100)) {
+    fprintf(stderr, "invalid percentile %s (0-100)\n", entry);
+    exit(EXIT_FAILURE);
+  }
+  double r = ceil(p / 100 * (double) size);
+  return (r < 1) ? 0 : (r >= (double) size) ? size - 1 : (size_t) r - 1;
+}
+
+size_t Query_ranks(const char* ranks, const char* percentiles, size_t size, size_t** k){
+  size_t n_k = 0;
+
+  *k = NULL;
+  if (ranks != NULL)
+    n_k = parse_list(ranks, size, k, n_k, parse_rank);
+  if (percentiles != NULL)
+    n_k = parse_list(percentiles, size, k, n_k, parse_percentile);
+  return n_k;
+}
+
+/**
+ * @brief Partition X[lo, hi) in (< low, [low, high], > high): the middle
+ * part is X[*a, *b).
+ */
+static void partition3(DATATYPE* X, size_t lo, size_t hi, DATATYPE low, DATATYPE high, size_t* a, size_t* b){
+  size_t i = lo;
+
+  *a = lo;
+  *b = hi;
+  while (i < *b) {
+    if (X[i] < low)
+      swap_keys(&X[(*a)++], &X[i++]);
+    else if (high < X[i])
+      swap_keys(&X[i], &X[--(*b)]);
+    else
+      i++;
+  }
+}
+
+DATATYPE Select_kth(DATATYPE* X, size_t n, size_t size, size_t k, int rank, int n_rank, MPI_Comm comm){
+  size_t lo = 0, hi = n, active = size; // the candidates are X[lo, hi), active on all the processes
+  uint64_t state = 0x5E1EC7ULL + (uint64_t) rank;
+  int *counts = NULL, *displs = NULL, same = 0;
+  DATATYPE *sample = malloc((SELECT_SAMPLE + 1) * sizeof(DATATYPE)), *all = NULL, pivot[2], result;
+
+  if (rank == 0) {
+    counts = malloc(n_rank * sizeof(int));
+    displs = malloc(n_rank * sizeof(int));
+  }
+
+  while (active > SELECT_GATHER) {
+    // sample in proportion to the candidates of the process (at least one if any)
+    size_t window = hi - lo;
+    int s = (int) ((SELECT_SAMPLE * window + active - 1) / active);
+    for (int i = 0; i < s; i++)
+      sample[i] = X[lo + next_random(&state) % window];
+
+    MPI_Gather(&s, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0) {
+      int total = 0;
+      for (int r = 0; r < n_rank; r++) {
+        displs[r] = total;
+        total += counts[r];
+      }
+      all = realloc(all, total * sizeof(DATATYPE));
+      MPI_Gatherv(sample, s, MPITYPE, all, counts, displs, MPITYPE, 0, comm);
+      pdq_sort(all, total);
+
+      // pivots around the expected position of k in the sample; a single one
+      // when the last step kept every candidate (it is removed or it is the answer)
+      size_t at = (size_t) ((double) k / active * total);
+      size_t delta = same ? 0 : (size_t) sqrt((double) total);
+      at = (at < (size_t) total) ? at : (size_t) total - 1;
+      pivot[0] = all[(at > delta) ? at - delta : 0];
+      pivot[1] = all[(at + delta < (size_t) total) ? at + delta : (size_t) total - 1];
+    } else
+      MPI_Gatherv(sample, s, MPITYPE, NULL, NULL, NULL, MPITYPE, 0, comm);
+    MPI_Bcast(pivot, 2, MPITYPE, 0, comm);
+
+    size_t a, b, local[2], sum[2];
+    partition3(X, lo, hi, pivot[0], pivot[1], &a, &b);
+    local[0] = a - lo;
+    local[1] = b - a;
+    MPI_Allreduce(local, sum, 2, MPI_SIZE_T, MPI_SUM, comm);
+
+    size_t before = active;
+    if (k < sum[0]) {
+      hi = a;
+      active = sum[0];
+    } else if (k < sum[0] + sum[1]) {
+      if (!(pivot[0] < pivot[1])) { // all the middle keys are equal
+        free(sample);
+        free(all);
+        free(counts);
+        free(displs);
+        return pivot[0];
+      }
+      k -= sum[0];
+      lo = a;
+      hi = b;
+      active = sum[1];
+    } else {
+      k -= sum[0] + sum[1];
+      lo = b;
+      active -= sum[0] + sum[1];
+    }
+    same = (active == before);
+  }
+
+  // few candidates left: sort them on rank 0
+  int s = (int) (hi - lo);
+  MPI_Gather(&s, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+  if (rank == 0) {
+    int total = 0;
+    for (int r = 0; r < n_rank; r++) {
+      displs[r] = total;
+      total += counts[r];
+    }
+    all = realloc(all, (total > 0 ? total : 1) * sizeof(DATATYPE));
+    MPI_Gatherv(X + lo, s, MPITYPE, all, counts, displs, MPITYPE, 0, comm);
+    pdq_sort(all, total);
+    result = all[k];
+  } else
+    MPI_Gatherv(X + lo, s, MPITYPE, NULL, NULL, NULL, MPITYPE, 0, comm);
+  MPI_Bcast(&result, 1, MPITYPE, 0, comm);
+
+  free(sample);
+  free(all);
+  free(counts);
+  free(displs);
+  return result;
+}
+
+// restore the min-heap property from the root of heap[0, m)
+static void sift_down(DATATYPE* heap, size_t m, size_t i){
+  DATATYPE x = heap[i];
+  for (;;) {
+    size_t c = 2 * i + 1;
+    if (c >= m)
+      break;
+    if (c + 1 < m && heap[c + 1] < heap[c])
+      c++;
+    if (!(heap[c] < x))
+      break;
+    heap[i] = heap[c];
+    i = c;
+  }
+  heap[i] = x;
+}
+
+size_t Top_k(const DATATYPE* X, size_t n, size_t size, size_t k, DATATYPE* top, int rank, int n_rank, MPI_Comm comm){
+  Merge_tree tree = Merge_schedule(rank, n_rank);
+  size_t m = (k < n) ? k : n, cap = (k < size) ? k : size;
+  DATATYPE *heap = malloc((cap > 0 ? cap : 1) * sizeof(DATATYPE));
+  DATATYPE *recv = NULL, *merged = NULL;
+
+  // the k largest keys of the process: a min-heap whose root is the smallest kept
+  memcpy(heap, X, m * sizeof(DATATYPE));
+  for (size_t i = m / 2; i-- > 0;)
+    sift_down(heap, m, i);
+  for (size_t i = m; i < n && m > 0; i++)
+    if (heap[0] < X[i]) {
+      heap[0] = X[i];
+      sift_down(heap, m, 0);
+    }
+  // popping the roots leaves them in descending order from the back
+  for (size_t i = m; i-- > 1;) {
+    swap_keys(&heap[0], &heap[i]);
+    sift_down(heap, i, 0);
+  }
+  for (size_t i = 0; i < m / 2; i++) // ascending
+    swap_keys(&heap[i], &heap[m - 1 - i]);
+
+  if (tree.n_children > 0) {
+    recv = malloc((cap > 0 ? cap : 1) * sizeof(DATATYPE));
+    merged = malloc((2 * cap > 0 ? 2 * cap : 1) * sizeof(DATATYPE));
+  }
+  for (int c = 0; c < tree.n_children; c++) { // keep the k largest of the lists of the children
+    size_t sub = Slice_offset(size, tree.child_end[c], n_rank) - Slice_offset(size, tree.child[c], n_rank);
+    size_t nb = (k < sub) ? k : sub;
+    TRACE_BEGIN(t_recv)
+    Recv_large(recv, nb, MPITYPE, tree.child[c], 0, comm);
+    TRACE_END(t_recv, "recv", c, nb * sizeof(DATATYPE));
+    merge_simd(heap, m, recv, nb, merged);
+    size_t keep = (m + nb < k) ? m + nb : k;
+    memcpy(heap, merged + (m + nb - keep), keep * sizeof(DATATYPE));
+    m = keep;
+  }
+  if (tree.parent >= 0) {
+    TRACE_BEGIN(t_send)
+    Send_large(heap, m, MPITYPE, tree.parent, 0, comm);
+    TRACE_END(t_send, "send", tree.n_children, m * sizeof(DATATYPE));
+  } else
+    memcpy(top, heap, m * sizeof(DATATYPE));
+
+  free(heap);
+  free(recv);
+  free(merged);
+  return m;
+}
+
+double Select_queries(DATATYPE* local_array, size_t local_size, size_t size, const size_t* k, size_t n_k,
+                      size_t k_top, DATATYPE* answers, int rank, int n_rank, MPI_Comm comm){
+  double start, end, sum;
+
+  START_T(start)
+    for (size_t q = 0; q < n_k; q++)
+      answers[q] = Select_kth(local_array, local_size, size, k[q], rank, n_rank, comm);
+    if (k_top > 0)
+      Top_k(local_array, local_size, size, k_top, answers + n_k, rank, n_rank, comm);
+  END_T(end, start, comm, sum, "select", local_size * sizeof(DATATYPE))
+
+  return sum / n_rank;
+}
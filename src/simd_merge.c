@@ -0,0 +1,364 @@
+/**
+ * @file simd_merge.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Merge kernels: bitonic merge networks on SIMD registers and branchless scalar merge
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/simd_merge.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMD_MERGE_X86 1
+#include <immintrin.h>
+#endif
+
+// 1 if DATATYPE is the type T
+#define KEY_IS(T) _Generic((DATATYPE)0, T: 1, default: 0)
+
+typedef void (*merge_fn)(const DATATYPE*, size_t, const DATATYPE*, size_t, DATATYPE*);
+
+/* ------------------------------ scalar merge ------------------------------ */
+
+#define DEFINE_MERGE_BRANCHLESS(NAME, T)                                          \
+static inline void NAME(const T* A, size_t na, const T* B, size_t nb, T* out){   \
+  size_t i = 0, j = 0, o = 0;                                                     \
+  while (i < na && j < nb) {                                                      \
+    T a = A[i], b = B[j];                                                         \
+    int take_a = a <= b;                                                          \
+    out[o++] = take_a ? a : b;                                                    \
+    i += take_a;                                                                  \
+    j += !take_a;                                                                 \
+  }                                                                               \
+  memcpy(out + o, A + i, (na - i) * sizeof(T));                                   \
+  memcpy(out + o + na - i, B + j, (nb - j) * sizeof(T));                          \
+}
+
+DEFINE_MERGE_BRANCHLESS(merge_branchless_key, DATATYPE)
+
+void merge_branchless(const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb, DATATYPE* out){
+  merge_branchless_key(A, na, B, nb, out);
+}
+
+#ifdef SIMD_MERGE_X86
+
+DEFINE_MERGE_BRANCHLESS(merge_scalar_i32, int32_t)
+DEFINE_MERGE_BRANCHLESS(merge_scalar_i64, int64_t)
+DEFINE_MERGE_BRANCHLESS(merge_scalar_u64, uint64_t)
+DEFINE_MERGE_BRANCHLESS(merge_scalar_f32, float)
+DEFINE_MERGE_BRANCHLESS(merge_scalar_f64, double)
+
+/*
+ * Vectorized merge (Inoue et al.): the two registers a and b hold W sorted elements each,
+ * the bitonic network leaves the W smallest ones in a (stored to the output) and
+ * the W largest ones in b; a is then reloaded from the input whose next element is smaller.
+ * When that input has less than W elements left, b and the leftovers are merged with
+ * the branchless scalar merge: b with the short leftover on the stack, then with the long one.
+ * Keys that are not signed integers go through the network as the signed integers of
+ * the same width and order given by MAP, which is its own inverse (see ORDER_MAP_*).
+ */
+#define DEFINE_SIMD_MERGE(NAME, TARGET, T, V, W, LOAD, STORE, MAP, NETWORK, SCALAR) \
+__attribute__((target(TARGET)))                                                   \
+static void NAME(const T* A, size_t na, const T* B, size_t nb, T* out){          \
+  size_t ia = W, ib = W, o = 0;                                                   \
+  T reg[W], buf[2 * W];                                                           \
+  V a, b;                                                                         \
+  if (na < W || nb < W) {                                                         \
+    SCALAR(A, na, B, nb, out);                                                    \
+    return;                                                                       \
+  }                                                                               \
+  a = MAP(LOAD(A));                                                               \
+  b = MAP(LOAD(B));                                                               \
+  for (;;) {                                                                      \
+    NETWORK(&a, &b);                                                              \
+    STORE(out + o, MAP(a));                                                       \
+    o += W;                                                                       \
+    if (ib >= nb || (ia < na && A[ia] <= B[ib])) {                                \
+      if (ia + W > na) break;                                                     \
+      a = MAP(LOAD(A + ia));                                                      \
+      ia += W;                                                                    \
+    } else {                                                                      \
+      if (ib + W > nb) break;                                                     \
+      a = MAP(LOAD(B + ib));                                                      \
+      ib += W;                                                                    \
+    }                                                                             \
+  }                                                                               \
+  STORE(reg, MAP(b));                                                             \
+  if (na - ia < W) { /* A is the short leftover */                                \
+    SCALAR(reg, W, A + ia, na - ia, buf);                                         \
+    SCALAR(buf, W + na - ia, B + ib, nb - ib, out + o);                           \
+  } else {                                                                        \
+    SCALAR(reg, W, B + ib, nb - ib, buf);                                         \
+    SCALAR(buf, W + nb - ib, A + ia, na - ia, out + o);                           \
+  }                                                                               \
+}
+
+/*
+ * Order preserving maps to signed integers: an unsigned key flips the sign bit, a negative
+ * float flips the other bits (larger magnitude, smaller key), so -0.0 comes before +0.0
+ * and a NaN is ordered by its bits: like the scalar merge, the keys are only permuted.
+ */
+#define NO_MAP(v) (v)
+#define ORDER_MAP_FLOAT(XOR, AND, SIGN, MAGNITUDE, v) XOR(v, AND(SIGN(v), MAGNITUDE))
+
+/* ---------------------------- SSE4.1, 4 x int32 --------------------------- */
+
+#define SSE_LOAD(p)     _mm_loadu_si128((const __m128i*)(p))
+#define SSE_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+
+// sort a bitonic sequence: compare-exchange at distance 2 and 1
+__attribute__((target("sse4.1")))
+static inline __m128i bitonic_sort_4x32(__m128i v){
+  __m128i p = _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2));
+  v = _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xF0);
+  p = _mm_shuffle_epi32(v, _MM_SHUFFLE(2,3,0,1));
+  return _mm_blend_epi16(_mm_min_epi32(v, p), _mm_max_epi32(v, p), 0xCC);
+}
+
+__attribute__((target("sse4.1")))
+static inline void bitonic_merge_4x32(__m128i* a, __m128i* b){
+  __m128i r = _mm_shuffle_epi32(*b, _MM_SHUFFLE(0,1,2,3)); // reversed: a,r is bitonic
+  __m128i lo = _mm_min_epi32(*a, r), hi = _mm_max_epi32(*a, r);
+  *a = bitonic_sort_4x32(lo);
+  *b = bitonic_sort_4x32(hi);
+}
+
+#define SSE_SIGN_32(v)  _mm_srai_epi32(v, 31)
+#define SSE_MAP_F32(v)  ORDER_MAP_FLOAT(_mm_xor_si128, _mm_and_si128, SSE_SIGN_32, _mm_set1_epi32(INT32_MAX), v)
+
+DEFINE_SIMD_MERGE(merge_sse4_i32, "sse4.1", int32_t, __m128i, 4, SSE_LOAD, SSE_STORE, NO_MAP, bitonic_merge_4x32, merge_scalar_i32)
+DEFINE_SIMD_MERGE(merge_sse4_f32, "sse4.1", float, __m128i, 4, SSE_LOAD, SSE_STORE, SSE_MAP_F32, bitonic_merge_4x32, merge_scalar_f32)
+
+/* ----------------------------- AVX2, 8 x int32 ---------------------------- */
+
+#define AVX_LOAD(p)     _mm256_loadu_si256((const __m256i*)(p))
+#define AVX_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+
+__attribute__((target("avx2")))
+static inline __m256i bitonic_sort_8x32(__m256i v){
+  __m256i p = _mm256_permute2x128_si256(v, v, 0x01);
+  v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xF0);
+  p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2));
+  v = _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xCC);
+  p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2,3,0,1));
+  return _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), 0xAA);
+}
+
+__attribute__((target("avx2")))
+static inline void bitonic_merge_8x32(__m256i* a, __m256i* b){
+  __m256i r = _mm256_permutevar8x32_epi32(*b, _mm256_setr_epi32(7,6,5,4,3,2,1,0));
+  __m256i lo = _mm256_min_epi32(*a, r), hi = _mm256_max_epi32(*a, r);
+  *a = bitonic_sort_8x32(lo);
+  *b = bitonic_sort_8x32(hi);
+}
+
+#define AVX_SIGN_32(v)  _mm256_srai_epi32(v, 31)
+#define AVX_MAP_F32(v)  ORDER_MAP_FLOAT(_mm256_xor_si256, _mm256_and_si256, AVX_SIGN_32, _mm256_set1_epi32(INT32_MAX), v)
+
+DEFINE_SIMD_MERGE(merge_avx2_i32, "avx2", int32_t, __m256i, 8, AVX_LOAD, AVX_STORE, NO_MAP, bitonic_merge_8x32, merge_scalar_i32)
+DEFINE_SIMD_MERGE(merge_avx2_f32, "avx2", float, __m256i, 8, AVX_LOAD, AVX_STORE, AVX_MAP_F32, bitonic_merge_8x32, merge_scalar_f32)
+
+/* ----------------------------- AVX2, 4 x int64 ---------------------------- */
+
+// AVX2 has no 64 bit min/max: compare and blend
+__attribute__((target("avx2")))
+static inline __m256i min_4x64(__m256i x, __m256i y){ return _mm256_blendv_epi8(x, y, _mm256_cmpgt_epi64(x, y)); }
+__attribute__((target("avx2")))
+static inline __m256i max_4x64(__m256i x, __m256i y){ return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi64(x, y)); }
+
+__attribute__((target("avx2")))
+static inline __m256i bitonic_sort_4x64(__m256i v){
+  __m256i p = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1,0,3,2));
+  v = _mm256_blend_epi32(min_4x64(v, p), max_4x64(v, p), 0xF0);
+  p = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(2,3,0,1));
+  return _mm256_blend_epi32(min_4x64(v, p), max_4x64(v, p), 0xCC);
+}
+
+__attribute__((target("avx2")))
+static inline void bitonic_merge_4x64(__m256i* a, __m256i* b){
+  __m256i r = _mm256_permute4x64_epi64(*b, _MM_SHUFFLE(0,1,2,3));
+  __m256i lo = min_4x64(*a, r), hi = max_4x64(*a, r);
+  *a = bitonic_sort_4x64(lo);
+  *b = bitonic_sort_4x64(hi);
+}
+
+// AVX2 has no 64 bit arithmetic shift: the sign comes from a comparison with 0
+#define AVX_SIGN_64(v)  _mm256_cmpgt_epi64(_mm256_setzero_si256(), v)
+#define AVX_MAP_F64(v)  ORDER_MAP_FLOAT(_mm256_xor_si256, _mm256_and_si256, AVX_SIGN_64, _mm256_set1_epi64x(INT64_MAX), v)
+#define AVX_MAP_U64(v)  _mm256_xor_si256(v, _mm256_set1_epi64x(INT64_MIN))
+
+DEFINE_SIMD_MERGE(merge_avx2_i64, "avx2", int64_t, __m256i, 4, AVX_LOAD, AVX_STORE, NO_MAP, bitonic_merge_4x64, merge_scalar_i64)
+DEFINE_SIMD_MERGE(merge_avx2_u64, "avx2", uint64_t, __m256i, 4, AVX_LOAD, AVX_STORE, AVX_MAP_U64, bitonic_merge_4x64, merge_scalar_u64)
+DEFINE_SIMD_MERGE(merge_avx2_f64, "avx2", double, __m256i, 4, AVX_LOAD, AVX_STORE, AVX_MAP_F64, bitonic_merge_4x64, merge_scalar_f64)
+
+/* ---------------------- AVX-512, 16 x int32 / 8 x int64 ------------------- */
+
+#define AVX512_LOAD(p)     _mm512_loadu_si512((const void*)(p))
+#define AVX512_STORE(p, v) _mm512_storeu_si512((void*)(p), v)
+
+// compare-exchange at distance d: lane i is paired with lane i ^ d, the upper one (mask) takes the max
+#define AVX512_STAGE(v, SUF, IDX, MASK)                                         \
+  do {                                                                          \
+    __m512i p_ = _mm512_permutexvar_##SUF(IDX, v);                              \
+    v = _mm512_mask_blend_##SUF(MASK, _mm512_min_##SUF(v, p_), _mm512_max_##SUF(v, p_)); \
+  } while (0)
+
+__attribute__((target("avx512f")))
+static inline __m512i bitonic_sort_16x32(__m512i v){
+  AVX512_STAGE(v, epi32, _mm512_setr_epi32(8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7), 0xFF00);
+  AVX512_STAGE(v, epi32, _mm512_setr_epi32(4,5,6,7,0,1,2,3,12,13,14,15,8,9,10,11), 0xF0F0);
+  AVX512_STAGE(v, epi32, _mm512_setr_epi32(2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13), 0xCCCC);
+  AVX512_STAGE(v, epi32, _mm512_setr_epi32(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14), 0xAAAA);
+  return v;
+}
+
+__attribute__((target("avx512f")))
+static inline void bitonic_merge_16x32(__m512i* a, __m512i* b){
+  __m512i r = _mm512_permutexvar_epi32(_mm512_setr_epi32(15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0), *b);
+  __m512i lo = _mm512_min_epi32(*a, r), hi = _mm512_max_epi32(*a, r);
+  *a = bitonic_sort_16x32(lo);
+  *b = bitonic_sort_16x32(hi);
+}
+
+#define AVX512_SIGN_32(v) _mm512_srai_epi32(v, 31)
+#define AVX512_MAP_F32(v) ORDER_MAP_FLOAT(_mm512_xor_si512, _mm512_and_si512, AVX512_SIGN_32, _mm512_set1_epi32(INT32_MAX), v)
+
+DEFINE_SIMD_MERGE(merge_avx512_i32, "avx512f", int32_t, __m512i, 16, AVX512_LOAD, AVX512_STORE, NO_MAP, bitonic_merge_16x32, merge_scalar_i32)
+DEFINE_SIMD_MERGE(merge_avx512_f32, "avx512f", float, __m512i, 16, AVX512_LOAD, AVX512_STORE, AVX512_MAP_F32, bitonic_merge_16x32, merge_scalar_f32)
+
+__attribute__((target("avx512f")))
+static inline __m512i bitonic_sort_8x64(__m512i v){
+  AVX512_STAGE(v, epi64, _mm512_setr_epi64(4,5,6,7,0,1,2,3), 0xF0);
+  AVX512_STAGE(v, epi64, _mm512_setr_epi64(2,3,0,1,6,7,4,5), 0xCC);
+  AVX512_STAGE(v, epi64, _mm512_setr_epi64(1,0,3,2,5,4,7,6), 0xAA);
+  return v;
+}
+
+__attribute__((target("avx512f")))
+static inline void bitonic_merge_8x64(__m512i* a, __m512i* b){
+  __m512i r = _mm512_permutexvar_epi64(_mm512_setr_epi64(7,6,5,4,3,2,1,0), *b);
+  __m512i lo = _mm512_min_epi64(*a, r), hi = _mm512_max_epi64(*a, r);
+  *a = bitonic_sort_8x64(lo);
+  *b = bitonic_sort_8x64(hi);
+}
+
+#define AVX512_SIGN_64(v) _mm512_srai_epi64(v, 63)
+#define AVX512_MAP_F64(v) ORDER_MAP_FLOAT(_mm512_xor_si512, _mm512_and_si512, AVX512_SIGN_64, _mm512_set1_epi64(INT64_MAX), v)
+#define AVX512_MAP_U64(v) _mm512_xor_si512(v, _mm512_set1_epi64(INT64_MIN))
+
+DEFINE_SIMD_MERGE(merge_avx512_i64, "avx512f", int64_t, __m512i, 8, AVX512_LOAD, AVX512_STORE, NO_MAP, bitonic_merge_8x64, merge_scalar_i64)
+DEFINE_SIMD_MERGE(merge_avx512_u64, "avx512f", uint64_t, __m512i, 8, AVX512_LOAD, AVX512_STORE, AVX512_MAP_U64, bitonic_merge_8x64, merge_scalar_u64)
+DEFINE_SIMD_MERGE(merge_avx512_f64, "avx512f", double, __m512i, 8, AVX512_LOAD, AVX512_STORE, AVX512_MAP_F64, bitonic_merge_8x64, merge_scalar_f64)
+
+#endif /* SIMD_MERGE_X86 */
+
+/* ------------------------------ dispatching ------------------------------- */
+
+// resolved once before main (see merge_kernel_init), never written by the merges
+static merge_fn merge_kernel = merge_branchless;
+static const char* merge_kernel_id = "scalar";
+
+/**
+ * @brief Kernel named name for DATATYPE, if the CPU supports it (NULL otherwise)
+ */
+static merge_fn kernel_for(const char* name){
+  if (strcmp(name, "scalar") == 0)
+    return merge_branchless;
+#ifdef SIMD_MERGE_X86
+  __builtin_cpu_init();
+  if (strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f")){
+    if (KEY_IS(int32_t)) return (merge_fn) merge_avx512_i32;
+    if (KEY_IS(int64_t)) return (merge_fn) merge_avx512_i64;
+    if (KEY_IS(uint64_t)) return (merge_fn) merge_avx512_u64;
+    if (KEY_IS(float)) return (merge_fn) merge_avx512_f32;
+    if (KEY_IS(double)) return (merge_fn) merge_avx512_f64;
+  }
+  if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")){
+    if (KEY_IS(int32_t)) return (merge_fn) merge_avx2_i32;
+    if (KEY_IS(int64_t)) return (merge_fn) merge_avx2_i64;
+    if (KEY_IS(uint64_t)) return (merge_fn) merge_avx2_u64;
+    if (KEY_IS(float)) return (merge_fn) merge_avx2_f32;
+    if (KEY_IS(double)) return (merge_fn) merge_avx2_f64;
+  }
+  if (strcmp(name, "sse4") == 0 && __builtin_cpu_supports("sse4.1")){
+    if (KEY_IS(int32_t)) return (merge_fn) merge_sse4_i32;
+    if (KEY_IS(float)) return (merge_fn) merge_sse4_f32;
+  }
+#endif
+  return NULL;
+}
+
+const char* merge_kernel_select(const char* name){
+  static const char* by_preference[] = {"avx512", "avx2", "sse4", "scalar"};
+  merge_fn k = NULL;
+
+  if (name != NULL && strcmp(name, "auto") != 0 && (k = kernel_for(name)) != NULL){
+    merge_kernel_id = name;
+  }else{
+    if (name != NULL && strcmp(name, "auto") != 0)
+      fprintf(stderr, "merge kernel %s unknown or not supported for %s keys on this CPU, using the best available\n",
+              name, DATATYPE_NAME);
+    for (int i = 0; k == NULL; i++)
+      if ((k = kernel_for(by_preference[i])) != NULL)
+        merge_kernel_id = by_preference[i];
+  }
+  merge_kernel = k;
+  return merge_kernel_id;
+}
+
+const char* merge_kernel_name(void){
+  return merge_kernel_id;
+}
+
+// the best kernel is chosen before main: the OpenMP merges only read merge_kernel
+__attribute__((constructor))
+static void merge_kernel_init(void){
+  merge_kernel_select(NULL);
+}
+
+void merge_simd(const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb, DATATYPE* out){
+  // the runs are already in order (or one is empty): the merge is a copy
+  if (na == 0 || nb == 0 || !(B[0] < A[na - 1])) {
+    memcpy(out, A, na * sizeof(DATATYPE));
+    memcpy(out + na, B, nb * sizeof(DATATYPE));
+    return;
+  }
+  if (B[nb - 1] < A[0]) {
+    memcpy(out, B, nb * sizeof(DATATYPE));
+    memcpy(out + nb, A, na * sizeof(DATATYPE));
+    return;
+  }
+  merge_kernel(A, na, B, nb, out);
+}
@@ -0,0 +1,170 @@
+/**
+ * @file trace.c
+ * @author Mario Pellegrino
+ * @author Francesco Sonnessa
+ * @brief Per-rank phase timeline, dumped as CSV and Chrome trace JSON
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+/** 
+ * Course: High Performance Computing 2021/2022
+ *
+ * Lecturer: Francesco Moscato    fmoscato@unisa.it
+ *
+ * Group:
+ * Mario Pellegrino    0622701671  m.pellegrino42@studenti.unisa.it
+ * Francesco Sonnessa   0622701672   f.sonnessa@studenti.unisa.it
+ *
+ * Copyright (C) 2021 - All Rights Reserved 
+ *
+ * This file is part of Contest - MPI.
+ *
+ * Contest - MPI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Contest - MPI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Contest - MPI.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "../include/trace.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Trace_event* events = NULL; // ring buffer of TRACE_CAPACITY events, NULL when tracing is off
+static size_t n_events = 0;        // events recorded (the last TRACE_CAPACITY are kept)
+static double t0;                  // common time origin
+static char* trace_prefix = NULL;
+
+void Trace_init(const char* prefix, MPI_Comm comm){
+  if (prefix == NULL)
+    return;
+  events = malloc(TRACE_CAPACITY * sizeof(Trace_event));
+  trace_prefix = malloc(strlen(prefix) + 1);
+  strcpy(trace_prefix, prefix);
+  n_events = 0;
+  MPI_Barrier(comm); // once, so that the timelines of the processes line up
+  t0 = MPI_Wtime();
+}
+
+void Trace_record(const char* phase, int level, double start, double end, size_t bytes){
+  if (events == NULL)
+    return;
+  Trace_event* e = &events[n_events % TRACE_CAPACITY];
+  e->phase = phase;
+  e->level = level;
+  e->start = start - t0;
+  e->duration = end - start;
+  e->bytes = bytes;
+  n_events++;
+}
+
+// append to the growing string *buf of length *len and capacity *cap
+static void append(char** buf, size_t* len, size_t* cap, const char* fmt, ...){
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = vsnprintf(*buf + *len, *cap - *len, fmt, ap);
+  va_end(ap);
+  if (*len + n + 1 > *cap) {
+    *cap = 2 * (*len + n + 1);
+    *buf = realloc(*buf, *cap);
+    va_start(ap, fmt);
+    vsnprintf(*buf + *len, *cap - *len, fmt, ap);
+    va_end(ap);
+  }
+  *len += n;
+}
+
+void Trace_finish(MPI_Comm comm){
+  int rank, n_rank;
+  size_t first, kept;
+  char name[4096];
+
+  if (events == NULL) // tracing is on on every process or on none
+    return;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &n_rank);
+  first = (n_events > TRACE_CAPACITY) ? n_events - TRACE_CAPACITY : 0;
+  kept = n_events - first;
+
+  // per-rank CSV
+  snprintf(name, sizeof(name), "%s.%d.csv", trace_prefix, rank);
+  FILE* f = fopen(name, "w");
+  if (f == NULL)
+    fprintf(stderr, "rank %d: cannot write the trace %s\n", rank, name);
+  else {
+    fprintf(f, "rank;phase;level;start_us;duration_us;bytes\n");
+    for (size_t i = first; i < n_events; i++) {
+      const Trace_event* e = &events[i % TRACE_CAPACITY];
+      fprintf(f, "%d;%s;%d;%.3f;%.3f;%zu\n", rank, e->phase, e->level, e->start * 1e6, e->duration * 1e6, e->bytes);
+    }
+    fclose(f);
+  }
+
+  // Chrome trace events of this process, gathered on rank 0
+  size_t len = 0, cap = 256 + kept * 128;
+  char* text = malloc(cap);
+  text[0] = '\0';
+  append(&text, &len, &cap, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", rank, rank);
+  for (size_t i = first; i < n_events; i++) {
+    const Trace_event* e = &events[i % TRACE_CAPACITY];
+    append(&text, &len, &cap, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,"
+           "\"args\":{\"level\":%d,\"bytes\":%zu}}", e->phase, rank, e->start * 1e6, e->duration * 1e6, e->level, e->bytes);
+  }
+  if (first > 0)
+    fprintf(stderr, "rank %d: trace ring full, the first %zu events were dropped\n", rank, first);
+
+  int n = (int) len, *counts = NULL, *displs = NULL;
+  char* all = NULL;
+  if (rank == 0) {
+    counts = malloc(n_rank * sizeof(int));
+    displs = malloc(n_rank * sizeof(int));
+  }
+  MPI_Gather(&n, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+  if (rank == 0) {
+    size_t total = 0;
+    for (int r = 0; r < n_rank; r++) {
+      displs[r] = (int) total;
+      total += counts[r];
+    }
+    all = malloc(total + 1);
+  }
+  MPI_Gatherv(text, n, MPI_CHAR, all, counts, displs, MPI_CHAR, 0, comm);
+
+  if (rank == 0) {
+    snprintf(name, sizeof(name), "%s.json", trace_prefix);
+    f = fopen(name, "w");
+    if (f == NULL)
+      fprintf(stderr, "cannot write the trace %s\n", name);
+    else {
+      fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      for (int r = 0; r < n_rank; r++) {
+        fwrite(all + displs[r], 1, counts[r], f);
+        fprintf(f, (r < n_rank - 1) ? ",\n" : "\n");
+      }
+      fprintf(f, "]}\n");
+      fclose(f);
+    }
+    free(all);
+    free(counts);
+    free(displs);
+  }
+
+  free(text);
+  free(events);
+  free(trace_prefix);
+  events = NULL;
+  trace_prefix = NULL;
+}
@@ -36,64 +36,116 @@
  */
 #include "../include/utils.h"
 
+void merge_rec(DATATYPE* restrict X, size_t n, DATATYPE* restrict tmp) {
+   merge_simd(X, n/2, X + n/2, n - n/2, tmp);
+}
+
+
+// branchless compare-exchange, X[i] <= X[j] afterwards
+#define CMP_SWAP(X, i, j) do {                       \
+      DATATYPE a_ = (X)[i], b_ = (X)[j];              \
+      (X)[i] = (b_ < a_) ? b_ : a_;                   \
+      (X)[j] = (b_ < a_) ? a_ : b_;                   \
+   } while (0)
+
 /**
- * @brief Check if the string parameter
- *  is a valid non-negative integer and convert it. 
- * If is invalid exit with failure
- * @param par string to be checked and converted
- * @return int The integer converted from the string
+ * @brief Sort a block of MERGESORT_BLOCK (8) elements with the optimal
+ * 19 comparators sorting network.
  */
-int check_int_input(const char* par){
-    /**
-     * from https://stackoverflow.com/questions/9748393/how-can-i-get-argv-as-int
-     * answer of https://stackoverflow.com/users/1201863/luc
-     */
-    char* p;
-    errno = 0; /*not 'int errno', because the '#include' already defined it*/
-    long arg = strtol(par, &p, 10);
-    if (*p != '\0' || errno != 0) {
-        fprintf(stderr,"not valid argument");
-        exit(EXIT_FAILURE); 
-    }
-    if (arg < INT_MIN || arg > INT_MAX) { /*if exceed the representation of int*/
-        fprintf(stderr,"argument exceed representation");
-        exit(EXIT_FAILURE);
-    }
-    int val = arg; /*#val now contains the size to be read*/
-    if(val < 0){
-        fprintf(stderr,"negative values not allowed");
-        exit(EXIT_FAILURE);
-    }
-    return val;
-}
-
-void merge_rec(DATATYPE* restrict X, int n, DATATYPE* restrict tmp) {
-   int i = 0;
-   int j = n/2;
-   int ti = 0;
-
-   while (i<n/2 && j<n) {
-      if (X[i] < X[j]) {
-         tmp[ti] = X[i];
-         ti++; i++;
-      } else {
-         tmp[ti] = X[j];
-         ti++; j++;
-      }
-   }
-   while (i<n/2) { /* finish up lower half */
-      tmp[ti] = X[i];
-      ti++; i++;
+static inline void sort_block(DATATYPE* X){
+   CMP_SWAP(X,0,2); CMP_SWAP(X,1,3); CMP_SWAP(X,4,6); CMP_SWAP(X,5,7);
+   CMP_SWAP(X,0,4); CMP_SWAP(X,1,5); CMP_SWAP(X,2,6); CMP_SWAP(X,3,7);
+   CMP_SWAP(X,0,1); CMP_SWAP(X,2,3); CMP_SWAP(X,4,5); CMP_SWAP(X,6,7);
+   CMP_SWAP(X,2,4); CMP_SWAP(X,3,5);
+   CMP_SWAP(X,1,4); CMP_SWAP(X,3,6);
+   CMP_SWAP(X,1,2); CMP_SWAP(X,3,4); CMP_SWAP(X,5,6);
+}
+
+/**
+ * @brief Insertion sort, for the last block when shorter than MERGESORT_BLOCK.
+ */
+static void insertion_sort(DATATYPE* X, size_t n){
+   for (size_t i = 1; i < n; i++) {
+      DATATYPE v = X[i];
+      size_t j = i;
+      for (; j > 0 && v < X[j-1]; j--)
+         X[j] = X[j-1];
+      X[j] = v;
    }
-   while (j<n) { /* finish up upper half */
-      tmp[ti] = X[j];
-      ti++; j++;
+}
+
+/**
+ * @brief Element of position k of the merge of A and B (without merging them).
+ */
+static DATATYPE merged_at(const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb, size_t k){
+   size_t i = co_rank(k + 1, A, na, B, nb), j = k + 1 - i;
+   if (i == 0) return B[j-1];
+   if (j == 0) return A[i-1];
+   return (A[i-1] < B[j-1]) ? B[j-1] : A[i-1];
+}
+
+/**
+ * @brief Co-rank of position d in the merge of the (virtual) merges AB and CD:
+ * how many elements of AB are among the first d of the 4-way merge.
+ */
+static size_t co_rank4(size_t d, const DATATYPE* const run[4], const size_t len[4]){
+   size_t nab = len[0] + len[1], ncd = len[2] + len[3];
+   size_t lo = (d > ncd) ? d - ncd : 0;
+   size_t hi = (d < nab) ? d : nab;
+
+   while (lo < hi) {
+      size_t i = lo + (hi - lo) / 2;
+      size_t j = d - i;
+      if (j > 0 && i < nab && !(merged_at(run[2], len[2], run[3], len[3], j-1) < merged_at(run[0], len[0], run[1], len[1], i)))
+         lo = i + 1;
+      else
+         hi = i;
    }
-   memcpy(X, tmp, n*sizeof(DATATYPE));
+   return lo;
 }
 
+/**
+ * @brief Merge the (up to) MERGESORT_WAYS = 4 runs of width w of src[lo..hi)
+ * into dst[lo..hi) in a single pass over the memory: the output is produced
+ * in segments of MERGESORT_SEGMENT elements, whose prefixes of the four runs
+ * are found with co_rank4; the two pairs are merged into buffers that stay
+ * in cache (buf holds 2 * MERGESORT_SEGMENT elements) and then into dst.
+ */
+static void merge_multiway(const DATATYPE* restrict src, size_t lo, size_t hi, size_t w, DATATYPE* restrict dst, DATATYPE* restrict buf){
+   const DATATYPE* run[4];
+   size_t len[4], pos[4] = {0, 0, 0, 0};
+   size_t n = hi - lo;
+
+   for (int r = 0; r < 4; r++) {
+      size_t s = lo + r * w;
+      run[r] = src + ((s < hi) ? s : hi);
+      len[r] = (s >= hi) ? 0 : (hi - s > w) ? w : hi - s;
+   }
+   if (len[2] == 0) { // at most two runs
+      merge_simd(run[0], len[0], run[1], len[1], dst + lo);
+      return;
+   }
+
+   for (size_t d0 = 0; d0 < n; d0 += MERGESORT_SEGMENT) {
+      size_t d1 = (n - d0 > MERGESORT_SEGMENT) ? d0 + MERGESORT_SEGMENT : n;
+      size_t e = co_rank4(d1, run, len); // elements of AB among the first d1
+      size_t end[4];
 
-void mergesort_rec(DATATYPE* restrict X, int n){
+      end[0] = co_rank(e, run[0], len[0], run[1], len[1]);
+      end[1] = e - end[0];
+      end[2] = co_rank(d1 - e, run[2], len[2], run[3], len[3]);
+      end[3] = d1 - e - end[2];
+
+      size_t nab = (end[0] - pos[0]) + (end[1] - pos[1]);
+      size_t ncd = (end[2] - pos[2]) + (end[3] - pos[3]);
+      merge_simd(run[0] + pos[0], end[0] - pos[0], run[1] + pos[1], end[1] - pos[1], buf);
+      merge_simd(run[2] + pos[2], end[2] - pos[2], run[3] + pos[3], end[3] - pos[3], buf + nab);
+      merge_simd(buf, nab, buf + nab, ncd, dst + lo + d0);
+      memcpy(pos, end, sizeof(pos));
+   }
+}
+
+void mergesort_rec(DATATYPE* restrict X, size_t n){
 
    DATATYPE* restrict tmp = malloc(n * sizeof(DATATYPE));
 
@@ -102,11 +154,197 @@ void mergesort_rec(DATATYPE* restrict X, int n){
 }
 
 // Seriale
-void mergesort_rec_h(DATATYPE* restrict X, int n, DATATYPE* restrict tmp){
-   if (n < 2) return;
+void mergesort_rec_h(DATATYPE* restrict X, size_t n, DATATYPE* restrict tmp){
+   mergesort_from_h(X, X, n, tmp);
+}
+
+void mergesort_from_h(const DATATYPE* in, DATATYPE* X, size_t n, DATATYPE* tmp){
+   const size_t tile = (n < MERGESORT_TILE) ? n : MERGESORT_TILE;
+   DATATYPE *src, *dst, *t, *buf;
+   size_t w, lo;
+   int passes = 0;
+
+   if (n < 2) {
+      if (n == 1 && in != X)
+         X[0] = in[0];
+      return;
+   }
+
+   // number of passes over the data: binary ones inside a tile, multiway ones across tiles
+   for (w = MERGESORT_BLOCK; w < tile; w *= 2) passes++;
+   for (; w < n; w *= MERGESORT_WAYS) passes++;
+
+   // sort the blocks into the buffer that makes the last pass end in X
+   // (the copy from in is fused with this pass)
+   src = (passes % 2) ? tmp : X;
+   dst = (passes % 2) ? X : tmp;
+   for (lo = 0; lo < n; lo += MERGESORT_BLOCK) {
+      size_t len = (n - lo > MERGESORT_BLOCK) ? MERGESORT_BLOCK : n - lo;
+      if (src != in)
+         memcpy(src + lo, in + lo, len * sizeof(DATATYPE));
+      if (len == MERGESORT_BLOCK)
+         sort_block(src + lo);
+      else
+         insertion_sort(src + lo, len);
+   }
+
+   // binary passes, one tile at a time while it is still in cache
+   for (size_t t0 = 0; t0 < n; t0 += tile) {
+      size_t t1 = (n - t0 > tile) ? t0 + tile : n;
+      DATATYPE *s = src, *d = dst;
+      for (w = MERGESORT_BLOCK; w < tile; w *= 2) {
+         for (lo = t0; lo < t1; lo += 2 * w) {
+            size_t mid = (t1 - lo > w) ? lo + w : t1;
+            size_t hi = (t1 - mid > w) ? mid + w : t1;
+            merge_simd(s + lo, mid - lo, s + mid, hi - mid, d + lo);
+         }
+         t = s; s = d; d = t;
+      }
+   }
+   for (w = MERGESORT_BLOCK; w < tile; w *= 2) {
+      t = src; src = dst; dst = t;
+   }
+
+   // multiway passes across the sorted tiles
+   if (w >= n) return;
+   buf = malloc(2 * MERGESORT_SEGMENT * sizeof(DATATYPE));
+   for (; w < n; w *= MERGESORT_WAYS) {
+      for (lo = 0; lo < n; lo += MERGESORT_WAYS * w) {
+         size_t hi = (n - lo > MERGESORT_WAYS * w) ? lo + MERGESORT_WAYS * w : n;
+         merge_multiway(src, lo, hi, w, dst, buf);
+      }
+      t = src; src = dst; dst = t;
+   }
+   free(buf);
+}
+
+void merge_ranges(const DATATYPE* restrict A, size_t na, const DATATYPE* restrict B, size_t nb, DATATYPE* restrict out){
+   merge_simd(A, na, B, nb, out);
+}
+
+size_t co_rank(size_t d, const DATATYPE* A, size_t na, const DATATYPE* B, size_t nb){
+   size_t lo = (d > nb) ? d - nb : 0;
+   size_t hi = (d < na) ? d : na;
+
+   // smallest i such that A[i] comes after B[d-i-1]
+   while (lo < hi) {
+      size_t i = lo + (hi - lo) / 2;
+      size_t j = d - i;
+      if (j > 0 && i < na && !(B[j-1] < A[i]))
+         lo = i + 1;
+      else
+         hi = i;
+   }
+   return lo;
+}
+
+/**
+ * @brief Merge the two sorted halves of X into out, split in
+ * pieces tasks of equal output size.
+ */
+static void merge_par(const DATATYPE* X, size_t n, DATATYPE* out, int pieces){
+   const DATATYPE *A = X, *B = X + n/2;
+   size_t na = n/2, nb = n - n/2;
+
+   for (int k = 0; k < pieces; k++) {
+      #pragma omp task firstprivate(k)
+      {
+         size_t d0 = n * k / pieces, d1 = n * (k+1) / pieces;
+         size_t i0 = co_rank(d0, A, na, B, nb), i1 = co_rank(d1, A, na, B, nb);
+         merge_ranges(A + i0, i1 - i0, B + (d0 - i0), (d1 - i1) - (d0 - i0), out + d0);
+      }
+   }
+   #pragma omp taskwait
+}
+
+/**
+ * @brief Task parallel Merge Sort: the levels of the recursion alternate X and tmp
+ * as destination of the merge, so tmp must hold a copy of X on entry.
+ * The leaves are sorted by mergesort_rec_h. The result is stored in X.
+ */
+static void mergesort_par_h(DATATYPE* X, size_t n, DATATYPE* tmp, int pieces){
+   if (n < MERGESORT_TASK_CUTOFF) {
+      mergesort_rec_h(X, n, tmp);
+      return;
+   }
+
+   #pragma omp task
+   mergesort_par_h(tmp, n/2, X, pieces);
+   #pragma omp task
+   mergesort_par_h(tmp+(n/2), n-(n/2), X + n/2, pieces);
+   #pragma omp taskwait
+
+   if (n >= PAR_MERGE_CUTOFF)
+      merge_par(tmp, n, X, pieces);
+   else
+      merge_rec(tmp, n, X);
+}
+
+void mergesort_par(DATATYPE* X, size_t n, int n_threads){
+   mergesort_par_from(X, X, n, n_threads);
+}
+
+void mergesort_par_from(const DATATYPE* in, DATATYPE* X, size_t n, int n_threads){
+   DATATYPE* tmp = malloc((n > 0 ? n : 1) * sizeof(DATATYPE));
+
+   if (n_threads <= 1) {
+      mergesort_from_h(in, X, n, tmp);
+      free(tmp);
+      return;
+   }
 
-   mergesort_rec_h(X, n/2, tmp);
-   mergesort_rec_h(X+(n/2), n-(n/2), tmp + n/2);
+   #pragma omp parallel num_threads(n_threads)
+   {
+      #pragma omp for schedule(static)
+      for (size_t i = 0; i < n; i++) { // copy, spreading the pages among the threads
+         tmp[i] = in[i];
+         if (in != X)
+            X[i] = in[i];
+      }
+
+      #pragma omp single
+      mergesort_par_h(X, n, tmp, n_threads);
+   }
+   free(tmp);
+}
+
+/**
+ * @brief Restore the heap property from node i downward.
+ * The heap stores run indices ordered by the current head of each run.
+ */
+static void heap_sift_down(int* heap, int n, int i, DATATYPE** runs, const size_t* pos){
+   for (;;) {
+      int l = 2*i + 1, r = l + 1, m = i;
+      if (l < n && runs[heap[l]][pos[heap[l]]] < runs[heap[m]][pos[heap[m]]]) m = l;
+      if (r < n && runs[heap[r]][pos[heap[r]]] < runs[heap[m]][pos[heap[m]]]) m = r;
+      if (m == i) return;
+      int t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+      i = m;
+   }
+}
+
+void kway_merge(DATATYPE** runs, const size_t* lens, int k, DATATYPE* restrict out){
+   int* heap = malloc(k * sizeof(int));
+   size_t* pos = calloc(k, sizeof(size_t));
+   size_t o = 0;
+   int n = 0;
+
+   for (int i = 0; i < k; i++)
+      if (lens[i] > 0) heap[n++] = i;
+   for (int i = n/2 - 1; i >= 0; i--)
+      heap_sift_down(heap, n, i, runs, pos);
+
+   while (n > 1) {
+      int r = heap[0];
+      out[o++] = runs[r][pos[r]++];
+      if (pos[r] == lens[r]) heap[0] = heap[--n]; // run exhausted
+      heap_sift_down(heap, n, 0, runs, pos);
+   }
+   if (n == 1) { // last run left: plain copy
+      int r = heap[0];
+      memcpy(out + o, runs[r] + pos[r], (lens[r] - pos[r]) * sizeof(DATATYPE));
+   }
 
-   merge_rec(X, n, tmp);
+   free(heap);
+   free(pos);
 }
\ No newline at end of file